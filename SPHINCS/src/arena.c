@@ -0,0 +1,124 @@
+#include "arena.h"
+#include <string.h>
+#include <sys/mman.h>
+
+// Header occupying the cache line in front of each block's payload
+typedef struct arena_block {
+    size_t size; // Bytes including this header
+    struct arena_block *next;
+} arena_block;
+
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+void sphincs_wipe(void *ptr, size_t len) {
+    volatile uint8_t *p = ptr;
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+int sphincs_arena_init(sphincs_arena *arena, size_t size) {
+    if (!arena) return ARENA_NULL_POINTER;
+
+    // A failed init leaves no stale base behind, so destroy stays a no-op
+    memset(arena, 0, sizeof(*arena));
+    size = ROUND_UP(size > 0 ? size : 1, ARENA_HUGE_PAGE_SIZE);
+    void *base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED) {
+        arena->huge_pages = 1;
+    }
+#endif
+    if (base == MAP_FAILED) {
+        // No reserved huge pages: ask for transparent ones instead
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return ARENA_MAP_FAILED;
+#ifdef MADV_HUGEPAGE
+        madvise(base, size, MADV_HUGEPAGE);
+#endif
+    }
+#ifdef MADV_DONTDUMP
+    madvise(base, size, MADV_DONTDUMP);
+#endif
+    arena->locked = mlock(base, size) == 0;
+
+    arena->base = base;
+    arena->size = size;
+    arena->free_list = (arena_block *)arena->base;
+    arena->free_list->size = size;
+    arena->free_list->next = NULL;
+    pthread_mutex_init(&arena->lock, NULL);
+    return ARENA_SUCCESS;
+}
+
+void sphincs_arena_destroy(sphincs_arena *arena) {
+    if (!arena || !arena->base) return;
+
+    sphincs_wipe(arena->base, arena->size);
+    if (arena->locked) {
+        munlock(arena->base, arena->size);
+    }
+    munmap(arena->base, arena->size);
+    pthread_mutex_destroy(&arena->lock);
+    arena->base = NULL;
+}
+
+void *sphincs_arena_alloc(sphincs_arena *arena, size_t size) {
+    size_t need = ARENA_ALIGN + ROUND_UP(size > 0 ? size : 1, ARENA_ALIGN);
+    void *ptr = NULL;
+
+    pthread_mutex_lock(&arena->lock);
+    for (arena_block **link = &arena->free_list; *link; link = &(*link)->next) {
+        arena_block *block = *link;
+        if (block->size < need) {
+            continue;
+        }
+        // Split unless the remainder could not hold a header and one line
+        if (block->size - need >= 2 * ARENA_ALIGN) {
+            arena_block *rest = (arena_block *)((uint8_t *)block + need);
+            rest->size = block->size - need;
+            rest->next = block->next;
+            block->size = need;
+            *link = rest;
+        } else {
+            *link = block->next;
+        }
+        ptr = (uint8_t *)block + ARENA_ALIGN;
+        break;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    return ptr;
+}
+
+void sphincs_arena_free(sphincs_arena *arena, void *ptr) {
+    if (!arena || !ptr) return;
+
+    arena_block *block = (arena_block *)((uint8_t *)ptr - ARENA_ALIGN);
+    sphincs_wipe(ptr, block->size - ARENA_ALIGN);
+
+    pthread_mutex_lock(&arena->lock);
+    arena_block *prev = NULL;
+    arena_block *next = arena->free_list;
+    while (next && next < block) {
+        prev = next;
+        next = next->next;
+    }
+
+    // Merge with the following and preceding free blocks when adjacent
+    block->next = next;
+    if (next && (uint8_t *)block + block->size == (uint8_t *)next) {
+        block->size += next->size;
+        block->next = next->next;
+    }
+    if (prev && (uint8_t *)prev + prev->size == (uint8_t *)block) {
+        prev->size += block->size;
+        prev->next = block->next;
+    } else if (prev) {
+        prev->next = block;
+    } else {
+        arena->free_list = block;
+    }
+    pthread_mutex_unlock(&arena->lock);
+}
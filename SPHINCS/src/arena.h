@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define ARENA_HUGE_PAGE_SIZE (2u * 1024 * 1024)
+#define ARENA_ALIGN 64 // Every allocation starts on a cache line
+
+// Constants for error codes
+#define ARENA_SUCCESS 0
+#define ARENA_NULL_POINTER -1
+#define ARENA_MAP_FAILED -2
+
+struct arena_block;
+
+// Region for secret key material and tree caches. It is backed by 2 MB
+// huge pages when the system has them reserved (fewer TLB misses on
+// random tree access), locked into RAM when RLIMIT_MEMLOCK allows, and
+// excluded from core dumps. Freed blocks and the whole region on destroy
+// are wiped. Falls back to normal pages, and to unlocked memory, instead
+// of failing; huge_pages and locked report what was obtained. A failed
+// init leaves the arena zeroed, and destroying it then does nothing.
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    int huge_pages;
+    int locked;
+    pthread_mutex_t lock;
+    struct arena_block *free_list; // Address ordered
+} sphincs_arena;
+
+int sphincs_arena_init(sphincs_arena *arena, size_t size);
+void sphincs_arena_destroy(sphincs_arena *arena);
+
+// Returns NULL when the arena has no free block large enough
+void *sphincs_arena_alloc(sphincs_arena *arena, size_t size);
+void sphincs_arena_free(sphincs_arena *arena, void *ptr);
+
+// Overwrite memory in a way the compiler may not elide
+void sphincs_wipe(void *ptr, size_t len);
+
+#endif // ARENA_H
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "arena.h"
+#include "test_util.h"
+
+#define TEST_SIZE (64 * 1024)
+
+/* A freed block is handed out again by the next allocation that fits, and
+   comes back wiped */
+static void test_first_fit(void) {
+    sphincs_arena arena;
+    int ok = 1;
+
+    if (sphincs_arena_init(&arena, TEST_SIZE) != ARENA_SUCCESS) {
+        report("Arena first fit", 0);
+        return;
+    }
+    uint8_t* a = sphincs_arena_alloc(&arena, 256);
+    uint8_t* b = sphincs_arena_alloc(&arena, 256);
+    uint8_t* c = sphincs_arena_alloc(&arena, 256);
+    ok &= a && b && c && a < b && b < c;
+    ok &= ((uintptr_t)a % ARENA_ALIGN) == 0 && ((uintptr_t)b % ARENA_ALIGN) == 0;
+
+    memset(b, 0xA5, 256);
+    sphincs_arena_free(&arena, b);
+    uint8_t* d = sphincs_arena_alloc(&arena, 100);
+    ok &= d == b;
+    for (int i = 0; i < 100 && ok; ++i) {
+        ok &= d[i] == 0;
+    }
+    // Too large for the hole left by b, so it goes after c
+    uint8_t* e = sphincs_arena_alloc(&arena, 512);
+    ok &= e > c;
+    sphincs_arena_destroy(&arena);
+    report("Arena first fit", ok);
+}
+
+/* Freeing neighbours in any order merges them back into one block large
+   enough for the whole arena */
+static void test_coalescing(void) {
+    sphincs_arena arena;
+    void* blocks[4];
+    int ok = 1;
+
+    if (sphincs_arena_init(&arena, TEST_SIZE) != ARENA_SUCCESS) {
+        report("Arena coalescing", 0);
+        return;
+    }
+    size_t quarter = arena.size / 4 - ARENA_ALIGN;
+    for (int i = 0; i < 4; ++i) {
+        blocks[i] = sphincs_arena_alloc(&arena, quarter);
+        ok &= blocks[i] != NULL;
+    }
+    ok &= sphincs_arena_alloc(&arena, 1) == NULL;
+
+    // Middle first, then the neighbours on either side
+    sphincs_arena_free(&arena, blocks[1]);
+    sphincs_arena_free(&arena, blocks[2]);
+    sphincs_arena_free(&arena, blocks[0]);
+    sphincs_arena_free(&arena, blocks[3]);
+    ok &= sphincs_arena_alloc(&arena, arena.size - ARENA_ALIGN) == arena.base + ARENA_ALIGN;
+    sphincs_arena_destroy(&arena);
+    ok &= arena.base == NULL;
+    report("Arena coalescing", ok);
+}
+
+/* With no lockable memory the arena still works, just unlocked. Runs in a
+   child since the limit cannot be raised again, and drops root there when
+   it can because CAP_IPC_LOCK ignores the limit */
+static void test_mlock_fallback(void) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        report("Arena mlock fallback", 0);
+        return;
+    }
+    if (pid == 0) {
+        struct rlimit none = { 0, 0 };
+        sphincs_arena arena;
+        int ok = setrlimit(RLIMIT_MEMLOCK, &none) == 0;
+        if (geteuid() == 0 && setgid(65534) == 0 && setuid(65534) != 0) {
+            _exit(1);
+        }
+        ok &= sphincs_arena_init(&arena, TEST_SIZE) == ARENA_SUCCESS;
+        ok &= !arena.locked;
+        uint8_t* p = sphincs_arena_alloc(&arena, 128);
+        ok &= p != NULL;
+        if (p) {
+            memset(p, 1, 128);
+            sphincs_arena_free(&arena, p);
+        }
+        sphincs_arena_destroy(&arena);
+        _exit(ok ? 0 : 1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    report("Arena mlock fallback", WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+/* A failed init leaves nothing for destroy to unmap */
+static void test_failed_init(void) {
+    sphincs_arena arena;
+    memset(&arena, 0xFF, sizeof(arena));
+    int ok = sphincs_arena_init(&arena, SIZE_MAX / 2) == ARENA_MAP_FAILED;
+    ok &= arena.base == NULL && arena.size == 0 && arena.free_list == NULL;
+    sphincs_arena_destroy(&arena);
+    report("Arena failed init", ok);
+}
+
+int main() {
+    test_first_fit();
+    test_coalescing();
+    test_failed_init();
+    test_mlock_fallback();
+    return test_status();
+}
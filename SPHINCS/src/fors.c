@@ -1,95 +1,91 @@
 #include "fors.h"
-#include "wots.h"
 #include <string.h>
-#include "sha256.h"
-
-// Constants for error codes
-#define FORS_SUCCESS 0
-#define FORS_NULL_POINTER -1
-#define FORS_INVALID_SIGNATURE -2
-
-
-// Function to compute a FORS tree root
-static void fors_treehash(const uint8_t* leaf, uint32_t leaf_idx, int h, const uint8_t* auth_path, uint8_t* root) {
-    uint8_t buffer[2 * HASH_BYTES];
-    memcpy(buffer, leaf, HASH_BYTES);
-    
-    for (int i = 0; i < h; i++) {
-        if (leaf_idx & 1) {
-            // Hash the sibling (from the authentication path) with the current node
-            memcpy(buffer + HASH_BYTES, auth_path + i * HASH_BYTES, HASH_BYTES);
-        } else {
-            // Hash the current node with the sibling (from the authentication path)
-            memcpy(buffer, auth_path + i * HASH_BYTES, HASH_BYTES);
-        }
-        // Update the current node
-        sha256(buffer, 2 * HASH_BYTES, buffer);
-        leaf_idx >>= 1;
-    }
-    memcpy(root, buffer, HASH_BYTES);
-}
+#include "hash.h"
+#include "merkle.h"
+#include "rng.h"
 
-// Function to generate FORS public and secret keys
-void fors_keygen(fors_public_key *pk, fors_secret_key *sk, const uint8_t *seed) {
-    if (!pk || !sk || !seed) return;
 
-    // Generate WOTS+ secret keys
-    uint8_t wots_seeds[FORS_T][HASH_BYTES];
-    wots_generate_secret_keys(wots_seeds, seed);
+// Leaf leaf_idx of a tree is the hash of its secret PRF(tree seed || leaf_idx)
+static void compute_leaf_secret(const sphincs_hash_ctx *ctx, const uint8_t *tree_seed, uint32_t leaf_idx, uint8_t *secret) {
+    uint8_t input[HASH_BYTES + 4];
 
-    // Generate WOTS+ public keys and concatenate them to form the FORS public key
-    uint8_t wots_pub_keys[FORS_T][WOTS_W * HASH_BYTES];
-    wots_generate_public_keys(wots_pub_keys, wots_seeds);
-    memcpy(pk->root, wots_pub_keys, FORS_T * WOTS_W * HASH_BYTES);
+    memcpy(input, tree_seed, HASH_BYTES);
+    input[HASH_BYTES + 0] = (leaf_idx >> 24) & 0xFF;
+    input[HASH_BYTES + 1] = (leaf_idx >> 16) & 0xFF;
+    input[HASH_BYTES + 2] = (leaf_idx >> 8) & 0xFF;
+    input[HASH_BYTES + 3] = leaf_idx & 0xFF;
+    hash_prf(ctx, secret, input, sizeof(input));
+}
+
+static int build_tree(const sphincs_hash_ctx *ctx, const uint8_t *tree_seed, merkle_tree *tree) {
+    uint8_t secrets[FORS_T][HASH_BYTES];
 
-    // Store the WOTS+ secret keys in the FORS secret key
-    memcpy(sk->sk, wots_seeds, FORS_T * HASH_BYTES);
+    if (merkle_tree_alloc(tree, FORS_HEIGHT, NULL) != MERKLE_SUCCESS) return FORS_OUT_OF_MEMORY;
+    for (uint32_t i = 0; i < FORS_T; i++) {
+        compute_leaf_secret(ctx, tree_seed, i, secrets[i]);
+    }
+    hash_thash_batch(ctx, merkle_node(tree, 0, 0), secrets[0], HASH_BYTES, FORS_T);
+    merkle_tree_build(ctx, tree);
+    sphincs_wipe(secrets, sizeof(secrets));
+    return 0;
 }
 
-// Function to sign a message using FORS
-int fors_sign(fors_signature *sig, const uint8_t *msg, const fors_secret_key *sk, const uint8_t *seed) {
-    if (!sig || !msg || !sk || !seed) return FORS_NULL_POINTER;
+// FORS_HEIGHT bits of msg starting at tree * FORS_HEIGHT
+static uint32_t message_index(const uint8_t *msg, int tree) {
+    uint32_t idx = 0;
+    for (int bit = tree * FORS_HEIGHT; bit < (tree + 1) * FORS_HEIGHT; bit++) {
+        idx = (idx << 1) | ((msg[bit / 8] >> (7 - bit % 8)) & 1);
+    }
+    return idx;
+}
 
-    // Generate WOTS+ secret keys
-    uint8_t wots_seeds[FORS_T][HASH_BYTES];
-    wots_generate_secret_keys(wots_seeds, seed);
 
-    // Generate WOTS+ public keys and concatenate them to form the FORS public key
-    uint8_t wots_pub_keys[FORS_T][WOTS_W * HASH_BYTES];
-    wots_generate_public_keys(wots_pub_keys, wots_seeds);
-    memcpy(sig->pk.root, wots_pub_keys, FORS_T * WOTS_W * HASH_BYTES);
+// Function to generate FORS public and secret keys
+int fors_keygen(const sphincs_hash_ctx *ctx, fors_public_key *pk, fors_secret_key *sk, const uint8_t *seed) {
+    if (!ctx || !pk || !sk || !seed) return FORS_NULL_POINTER;
+
+    for (int i = 0; i < FORS_K; i++) {
+        merkle_tree tree;
+        rng_generate(sk->sk[i], HASH_BYTES);
+        if (build_tree(ctx, sk->sk[i], &tree) != 0) return FORS_OUT_OF_MEMORY;
+        memcpy(pk->root[i], merkle_root(&tree), HASH_BYTES);
+        merkle_tree_free(&tree);
+    }
 
-    // Store the WOTS+ secret keys in the FORS secret key
-    memcpy(sig->sk.sk, wots_seeds, FORS_T * HASH_BYTES);
+    return 0;
+}
 
-    // Compute the authentication path for each WOTS+ instance
-    uint32_t leaf_idx = 0;
-    for (int i = 0; i < FORS_T; i++) {
-        uint8_t leaf[HASH_BYTES];
-        wots_sign(leaf, msg, &(sk->sk[i]), &(seed[i * HASH_BYTES]));
-        fors_treehash(leaf, leaf_idx, FORS_HEIGHT, NULL, sig->auth_path[i]);
-        leaf_idx += (1 << FORS_HEIGHT);
+// Function to sign a message using FORS
+int fors_sign(const sphincs_hash_ctx *ctx, fors_signature *sig, const uint8_t *msg, const fors_secret_key *sk) {
+    if (!ctx || !sig || !msg || !sk) return FORS_NULL_POINTER;
+
+    // Reveal the selected leaf's secret in every tree, with its auth path
+    for (int i = 0; i < FORS_K; i++) {
+        uint32_t leaf_idx = message_index(msg, i);
+        merkle_tree tree;
+        if (build_tree(ctx, sk->sk[i], &tree) != 0) return FORS_OUT_OF_MEMORY;
+        compute_leaf_secret(ctx, sk->sk[i], leaf_idx, sig->signatures[i].sig);
+        merkle_auth_path(&tree, leaf_idx, sig->signatures[i].auth_path[0]);
+        merkle_tree_free(&tree);
     }
 
-    return FORS_SUCCESS;
+    return 0;
 }
 
 // Function to verify a FORS signature
-int fors_verify(const fors_signature *sig, const uint8_t *msg, const fors_public_key *pk) {
-    if (!sig || !msg || !pk) return FORS_NULL_POINTER;
+int fors_verify(const sphincs_hash_ctx *ctx, const fors_signature *sig, const uint8_t *msg, const fors_public_key *pk) {
+    if (!ctx || !sig || !msg || !pk) return FORS_NULL_POINTER;
 
-    // Verify the authentication path
-    uint32_t leaf_idx = 0;
-    for (int i = 0; i < FORS_T; i++) {
+    // Every tree's root, recomputed from the revealed secret, must match
+    for (int i = 0; i < FORS_K; i++) {
         uint8_t leaf[HASH_BYTES];
-        wots_verify(leaf, msg, &(sig->pk.root[i * WOTS_W * HASH_BYTES]), &(sig->auth_path[i]));
         uint8_t computed_root[HASH_BYTES];
-        fors_treehash(leaf, leaf_idx, FORS_HEIGHT, sig->auth_path[i], computed_root);
-        if (memcmp(computed_root, &(pk->root[i * WOTS_W * HASH_BYTES]), HASH_BYTES) != 0) {
-            return FORS_INVALID_SIGNATURE;
+        hash_thash(ctx, leaf, sig->signatures[i].sig, HASH_BYTES);
+        merkle_root_from_path(ctx, leaf, message_index(msg, i), sig->signatures[i].auth_path[0], FORS_HEIGHT, computed_root);
+        if (memcmp(computed_root, pk->root[i], HASH_BYTES) != 0) {
+            return 0;
         }
-        leaf_idx += (1 << FORS_HEIGHT);
     }
 
-    return FORS_SUCCESS;
-}
\ No newline at end of file
+    return 1;
+}
@@ -2,14 +2,22 @@
 #define FORS_H
 
 #include <stdint.h>
+#include "hash.h"
 
-#define FORS_K  // Number of trees
-#define FORS_HEIGHT  // Height of each tree
+#define FORS_K 33  // Number of trees
+#define FORS_HEIGHT 6  // Height of each tree
 #define HASH_BYTES 32  // Hash output size in bytes
-#define FORS_T 8
+#define FORS_T (1u << FORS_HEIGHT)  // Leaves per tree
 #define FORS_THRES 70
 #define FORS_SAMPLES 16
 
+// Constants for error codes
+#define FORS_NULL_POINTER -1
+#define FORS_OUT_OF_MEMORY -3
+
+// The FORS_K * FORS_HEIGHT leading bits of the message digest pick one
+// leaf per tree, FORS_HEIGHT bits each, most significant bit first
+
 // FORS public key structure
 typedef struct {
     uint8_t root[FORS_K][HASH_BYTES];
@@ -23,14 +31,19 @@ typedef struct {
 // FORS signature structure
 typedef struct {
     struct {
-        uint8_t sig[HASH_BYTES];
+        uint8_t sig[HASH_BYTES]; // The selected leaf's secret
         uint8_t auth_path[FORS_HEIGHT][HASH_BYTES];
     } signatures[FORS_K];
 } fors_signature;
 
 // Function prototypes
-void fors_keygen(fors_public_key *pk, fors_secret_key *sk, const uint8_t *seed);
-int fors_sign(fors_signature *sig, const uint8_t *msg, const fors_secret_key *sk, const uint8_t *seed);
-int fors_verify(const fors_signature *sig, const uint8_t *msg, const fors_public_key *pk);
+// Each tree's secret seed is drawn from the RNG, which the caller seeds
+int fors_keygen(const sphincs_hash_ctx *ctx, fors_public_key *pk, fors_secret_key *sk, const uint8_t *seed);
+// msg is a HASH_BYTES digest. Rebuilds each tree from sk, so nothing is
+// cached and concurrent calls with the same sk are safe.
+int fors_sign(const sphincs_hash_ctx *ctx, fors_signature *sig, const uint8_t *msg, const fors_secret_key *sk);
+// Returns 1 for a valid signature, 0 otherwise, FORS_NULL_POINTER for NULL
+// arguments: the same convention as xmss_verify
+int fors_verify(const sphincs_hash_ctx *ctx, const fors_signature *sig, const uint8_t *msg, const fors_public_key *pk);
 
 #endif // FORS_H
@@ -0,0 +1,260 @@
+#include "haraka.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Default Haraka v2 round constants, byte order as loaded by _mm_loadu_si128 */
+static const uint32_t haraka_rc_default[HARAKA_ROUND_CONSTANTS][4] = {
+    {0x75817b9d, 0xb2c5fef0, 0xe620c00a, 0x0684704c}, {0x2f08f717, 0x640f6ba4, 0x88f3a06b, 0x8b66b4e1},
+    {0x9f029114, 0xcf029d60, 0x53f28498, 0x3402de2d}, {0xfd5b4f79, 0xbbf3bcaf, 0x2e7b4f08, 0x0ed6eae6},
+    {0xbe397044, 0x79eecd1c, 0x4872448b, 0xcbcfb0cb}, {0x2b8a057b, 0x8d5335ed, 0x6e9032b7, 0x7eeacdee},
+    {0xda4fef1b, 0xe2412761, 0x5e2e7cd0, 0x67c28f43}, {0x1fc70b3b, 0x675ffde2, 0xafcacc07, 0x2924d9b0},
+    {0xb9d465ee, 0xecdb8fca, 0xe6867fe9, 0xab4d63f1}, {0xad037e33, 0x5b2a404f, 0xd4b7cd64, 0x1c30bf84},
+    {0x8df69800, 0x69028b2e, 0x941723bf, 0xb2cc0bb9}, {0x5c9d2d8a, 0x4aaa9ec8, 0xde6f5572, 0xfa0478a6},
+    {0x29129fd4, 0x0efa4f2e, 0x6b772a12, 0xdfb49f2b}, {0xbb6a12ee, 0x32d611ae, 0xf449a236, 0x1ea10344},
+    {0x9ca8eca6, 0x5f9600c9, 0x4b050084, 0xaf044988}, {0x27e593ec, 0x78a2c7e3, 0x9d199c4f, 0x21025ed8},
+    {0x82d40173, 0xb9282ecd, 0xa759c9b7, 0xbf3aaaf8}, {0x10307d6b, 0x37f2efd9, 0x6186b017, 0x6260700d},
+    {0xf6fc9ac6, 0x81c29153, 0x21300443, 0x5aca45c2}, {0x36d1943a, 0x2caf92e8, 0x226b68bb, 0x9223973c},
+    {0xe51071b4, 0x6cbab958, 0x225886eb, 0xd3bf9238}, {0x24e1128d, 0x933dfddd, 0xaef0c677, 0xdb863ce5},
+    {0xcb2212b1, 0x83e48de3, 0xffeba09c, 0xbb606268}, {0xc72bf77d, 0x2db91a4e, 0xe2e4d19c, 0x734bd3dc},
+    {0x2cb3924e, 0x4b1415c4, 0x61301b43, 0x43bb47c3}, {0x16eb6899, 0x03b231dd, 0xe707eff6, 0xdba775a8},
+    {0x7eca472c, 0x8e5e2302, 0x3c755977, 0x6df3614b}, {0xb88617f9, 0x6d1be5b9, 0xd6de7d77, 0xcda75a17},
+    {0xa946ee5d, 0x9d6c069d, 0x6ba8e9aa, 0xec6b43f0}, {0x3bf327c1, 0xa2531159, 0xf957332b, 0xcb1e6950},
+    {0x600ed0d9, 0xe4ed0353, 0x00da619c, 0x2cee0c75}, {0x63a4a350, 0x80bbbabc, 0x96e90cab, 0xf0b1a5a1},
+    {0x938dca39, 0xab0dde30, 0x5e962988, 0xae3db102}, {0x2e75b442, 0x8814f3a8, 0xd554a40b, 0x17bb8f38},
+    {0x360a16f6, 0xaeb6b779, 0x5f427fd7, 0x34bb8a5b}, {0xffbaafde, 0x43ce5918, 0xcbe55438, 0x26f65241},
+    {0x839ec978, 0xa2ca9cf7, 0xb9f3026a, 0x4ce99a54}, {0x22901235, 0x40c06e28, 0x1bdff7be, 0xae51a51a},
+    {0x48a659cf, 0xc173bc0f, 0xba7ed22b, 0xa0c1613c}, {0xe9c59da1, 0x4ad6bdfd, 0x02288288, 0x756acc03}
+};
+
+void haraka_init(haraka_ctx* ctx) {
+    for (int i = 0; i < HARAKA_ROUND_CONSTANTS; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            uint32_t w = haraka_rc_default[i][j];
+            ctx->rc[i][4 * j + 0] = w & 0xFF;
+            ctx->rc[i][4 * j + 1] = (w >> 8) & 0xFF;
+            ctx->rc[i][4 * j + 2] = (w >> 16) & 0xFF;
+            ctx->rc[i][4 * j + 3] = (w >> 24) & 0xFF;
+        }
+    }
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+#define HARAKA_TARGET __attribute__((target("aes,sse2")))
+
+#define LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define STORE(p, x) _mm_storeu_si128((__m128i*)(p), (x))
+#define RC(i) LOAD(ctx->rc[i])
+
+#define AES2(s0, s1, rci) \
+    s0 = _mm_aesenc_si128(s0, RC(rci)); \
+    s1 = _mm_aesenc_si128(s1, RC(rci + 1)); \
+    s0 = _mm_aesenc_si128(s0, RC(rci + 2)); \
+    s1 = _mm_aesenc_si128(s1, RC(rci + 3));
+
+#define AES4(s0, s1, s2, s3, rci) \
+    s0 = _mm_aesenc_si128(s0, RC(rci)); \
+    s1 = _mm_aesenc_si128(s1, RC(rci + 1)); \
+    s2 = _mm_aesenc_si128(s2, RC(rci + 2)); \
+    s3 = _mm_aesenc_si128(s3, RC(rci + 3)); \
+    s0 = _mm_aesenc_si128(s0, RC(rci + 4)); \
+    s1 = _mm_aesenc_si128(s1, RC(rci + 5)); \
+    s2 = _mm_aesenc_si128(s2, RC(rci + 6)); \
+    s3 = _mm_aesenc_si128(s3, RC(rci + 7));
+
+#define MIX2(s0, s1) \
+    tmp = _mm_unpacklo_epi32(s0, s1); \
+    s1 = _mm_unpackhi_epi32(s0, s1); \
+    s0 = tmp;
+
+#define MIX4(s0, s1, s2, s3) \
+    tmp = _mm_unpacklo_epi32(s0, s1); \
+    s0 = _mm_unpackhi_epi32(s0, s1); \
+    s1 = _mm_unpacklo_epi32(s2, s3); \
+    s2 = _mm_unpackhi_epi32(s2, s3); \
+    s3 = _mm_unpacklo_epi32(s0, s2); \
+    s0 = _mm_unpackhi_epi32(s0, s2); \
+    s2 = _mm_unpackhi_epi32(s1, tmp); \
+    s1 = _mm_unpacklo_epi32(s1, tmp);
+
+int haraka_available(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") != 0;
+}
+
+/* Haraka-512 permutation without the feed-forward */
+HARAKA_TARGET
+static void haraka512_perm(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    __m128i s0 = LOAD(in), s1 = LOAD(in + 16), s2 = LOAD(in + 32), s3 = LOAD(in + 48);
+    __m128i tmp;
+
+    AES4(s0, s1, s2, s3, 0);
+    MIX4(s0, s1, s2, s3);
+    AES4(s0, s1, s2, s3, 8);
+    MIX4(s0, s1, s2, s3);
+    AES4(s0, s1, s2, s3, 16);
+    MIX4(s0, s1, s2, s3);
+    AES4(s0, s1, s2, s3, 24);
+    MIX4(s0, s1, s2, s3);
+    AES4(s0, s1, s2, s3, 32);
+    MIX4(s0, s1, s2, s3);
+
+    STORE(out, s0);
+    STORE(out + 16, s1);
+    STORE(out + 32, s2);
+    STORE(out + 48, s3);
+}
+
+/* Four independent permutations; interleaving keeps the AES unit fed
+ * while each aesenc waits on the previous round of its own state */
+HARAKA_TARGET
+static void haraka512_perm_x4(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    __m128i s[4][4];
+    __m128i tmp;
+    int i, r;
+
+    for (i = 0; i < 4; ++i) {
+        s[i][0] = LOAD(in + 64 * i);
+        s[i][1] = LOAD(in + 64 * i + 16);
+        s[i][2] = LOAD(in + 64 * i + 32);
+        s[i][3] = LOAD(in + 64 * i + 48);
+    }
+    for (r = 0; r < HARAKA_ROUND_CONSTANTS; r += 8) {
+        AES4(s[0][0], s[0][1], s[0][2], s[0][3], r);
+        AES4(s[1][0], s[1][1], s[1][2], s[1][3], r);
+        AES4(s[2][0], s[2][1], s[2][2], s[2][3], r);
+        AES4(s[3][0], s[3][1], s[3][2], s[3][3], r);
+        for (i = 0; i < 4; ++i) {
+            MIX4(s[i][0], s[i][1], s[i][2], s[i][3]);
+        }
+    }
+    for (i = 0; i < 4; ++i) {
+        STORE(out + 64 * i, s[i][0]);
+        STORE(out + 64 * i + 16, s[i][1]);
+        STORE(out + 64 * i + 32, s[i][2]);
+        STORE(out + 64 * i + 48, s[i][3]);
+    }
+}
+
+HARAKA_TARGET
+void haraka256(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    __m128i s0 = LOAD(in), s1 = LOAD(in + 16);
+    __m128i tmp;
+
+    AES2(s0, s1, 0);
+    MIX2(s0, s1);
+    AES2(s0, s1, 4);
+    MIX2(s0, s1);
+    AES2(s0, s1, 8);
+    MIX2(s0, s1);
+    AES2(s0, s1, 12);
+    MIX2(s0, s1);
+    AES2(s0, s1, 16);
+    MIX2(s0, s1);
+
+    STORE(out, _mm_xor_si128(s0, LOAD(in)));
+    STORE(out + 16, _mm_xor_si128(s1, LOAD(in + 16)));
+}
+
+#else
+
+/* No AES-NI build: haraka_available() keeps the backend from being
+ * selected (hash_ctx_init returns HASH_UNAVAILABLE), and a direct call
+ * aborts rather than return unhashed input */
+int haraka_available(void) {
+    return 0;
+}
+
+static void haraka512_perm(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    (void)ctx; (void)in; (void)out;
+    abort();
+}
+
+static void haraka512_perm_x4(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    (void)ctx; (void)in; (void)out;
+    abort();
+}
+
+void haraka256(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    (void)ctx; (void)in; (void)out;
+    abort();
+}
+
+#endif
+
+/* Feed-forward and truncation shared by the single and four-way versions */
+static void haraka512_finish(const uint8_t* in, const uint8_t* perm, uint8_t* out) {
+    uint8_t buf[64];
+    int i;
+
+    for (i = 0; i < 64; ++i) {
+        buf[i] = perm[i] ^ in[i];
+    }
+
+    /* Truncate to the 256-bit output defined by Haraka-512 */
+    memcpy(out, buf + 8, 8);
+    memcpy(out + 8, buf + 24, 8);
+    memcpy(out + 16, buf + 32, 8);
+    memcpy(out + 24, buf + 48, 8);
+}
+
+void haraka512_256(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    uint8_t perm[64];
+
+    haraka512_perm(ctx, in, perm);
+    haraka512_finish(in, perm, out);
+}
+
+void haraka512_256_x4(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out) {
+    uint8_t perm[4 * 64];
+    int i;
+
+    haraka512_perm_x4(ctx, in, perm);
+    for (i = 0; i < 4; ++i) {
+        haraka512_finish(in + 64 * i, perm + 64 * i, out + 32 * i);
+    }
+}
+
+/* Haraka-S: sponge over the Haraka-512 permutation with a 32-byte rate */
+void haraka_S(const haraka_ctx* ctx, const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen) {
+    uint8_t s[64];
+    uint8_t buf[64];
+    size_t i;
+
+    memset(s, 0, sizeof(s));
+    while (inlen >= HARAKA_S_RATE) {
+        for (i = 0; i < HARAKA_S_RATE; ++i) {
+            s[i] ^= in[i];
+        }
+        haraka512_perm(ctx, s, buf);
+        memcpy(s, buf, sizeof(s));
+        in += HARAKA_S_RATE;
+        inlen -= HARAKA_S_RATE;
+    }
+
+    for (i = 0; i < inlen; ++i) {
+        s[i] ^= in[i];
+    }
+    s[inlen] ^= 0x1F;
+    s[HARAKA_S_RATE - 1] ^= 0x80;
+
+    while (outlen > 0) {
+        size_t take = outlen < HARAKA_S_RATE ? outlen : HARAKA_S_RATE;
+        haraka512_perm(ctx, s, buf);
+        memcpy(s, buf, sizeof(s));
+        memcpy(out, s, take);
+        out += take;
+        outlen -= take;
+    }
+}
+
+void haraka_tweak_constants(haraka_ctx* ctx, const uint8_t* seed, size_t seed_len) {
+    uint8_t buf[HARAKA_ROUND_CONSTANTS * 16];
+
+    /* The tweaked constants are squeezed using the default ones */
+    haraka_init(ctx);
+    haraka_S(ctx, seed, seed_len, buf, sizeof(buf));
+    memcpy(ctx->rc, buf, sizeof(buf));
+}
@@ -0,0 +1,30 @@
+#ifndef HARAKA_H
+#define HARAKA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HARAKA_ROUND_CONSTANTS 40
+#define HARAKA_S_RATE 32
+
+/* Haraka v2 round constants. The defaults are the published ones;
+ * haraka_tweak_constants re-derives them from a public seed the way the
+ * SPHINCS+ Haraka instantiation keys the hash. */
+typedef struct {
+    uint8_t rc[HARAKA_ROUND_CONSTANTS][16];
+} haraka_ctx;
+
+// Returns 1 when the CPU provides AES-NI, 0 otherwise. The permutations
+// must only be called when this returns 1; builds for targets without
+// AES-NI intrinsics always return 0 and abort if they are called anyway.
+int haraka_available(void);
+
+void haraka_init(haraka_ctx* ctx);
+void haraka_tweak_constants(haraka_ctx* ctx, const uint8_t* seed, size_t seed_len);
+
+void haraka256(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out);       /* 32 -> 32 bytes */
+void haraka512_256(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out);   /* 64 -> 32 bytes */
+void haraka512_256_x4(const haraka_ctx* ctx, const uint8_t* in, uint8_t* out); /* 4 x 64 -> 4 x 32 bytes */
+void haraka_S(const haraka_ctx* ctx, const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen);
+
+#endif // HARAKA_H
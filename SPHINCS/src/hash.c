@@ -0,0 +1,146 @@
+#include "hash.h"
+#include <string.h>
+
+/* Backends without a multi-lane kernel hash batches one input at a time */
+static void generic_thash_batch(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ctx->backend->thash(ctx, out + i * HASH_BYTES, in + i * inlen, inlen);
+    }
+}
+
+/* SHA-256: the public seed is padded to a full block so its compression
+ * can be done once per key and reused as a midstate. */
+static int sha256_backend_available(void) {
+    return 1;
+}
+
+static void sha256_backend_init(sphincs_hash_ctx *ctx) {
+    uint8_t block[SHA256_BLOCK_SIZE];
+    memset(block, 0, sizeof(block));
+    memcpy(block, ctx->pub_seed, HASH_BYTES);
+    sha256_init(&ctx->sha256_seeded);
+    sha256_update(&ctx->sha256_seeded, block, sizeof(block));
+}
+
+static void sha256_backend_thash(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    // Chain steps and tree nodes hash exactly one or two nodes
+    if (inlen == HASH_BYTES) {
+        sha256_midstate_32(&ctx->sha256_seeded, in, out);
+    } else if (inlen == 2 * HASH_BYTES) {
+        sha256_midstate_64(&ctx->sha256_seeded, in, out);
+    } else {
+        sha256_ctx state = ctx->sha256_seeded;
+        sha256_update(&state, in, inlen);
+        sha256_final(&state, out);
+    }
+}
+
+static void sha256_backend_prf(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    (void)ctx;
+    switch (inlen) {
+    case 32: sha256_32(in, out); break;
+    case 40: sha256_40(in, out); break;
+    case 64: sha256_64(in, out); break;
+    case 96: sha256_96(in, out); break;
+    default: sha256(in, inlen, out); break;
+    }
+}
+
+/* SHAKE256: plain prefixing, the sponge has no useful midstate at this size */
+static int shake256_backend_available(void) {
+    return 1;
+}
+
+static void shake256_backend_init(sphincs_hash_ctx *ctx) {
+    (void)ctx;
+}
+
+static void shake256_backend_thash(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    shake256_ctx state;
+    shake256_init(&state);
+    shake256_absorb(&state, ctx->pub_seed, HASH_BYTES);
+    shake256_absorb(&state, in, inlen);
+    shake256_finalize(&state);
+    shake256_squeeze(&state, out, HASH_BYTES);
+}
+
+static void shake256_backend_prf(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    (void)ctx;
+    shake256(in, inlen, out, HASH_BYTES);
+}
+
+/* Haraka: keyed through round constants derived from the public seed.
+ * The two fixed sizes that dominate signing go to the dedicated
+ * Haraka-256/512 functions, anything else through the Haraka-S sponge. */
+static void haraka_backend_init(sphincs_hash_ctx *ctx) {
+    haraka_tweak_constants(&ctx->haraka, ctx->pub_seed, HASH_BYTES);
+}
+
+static void haraka_backend_thash(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    if (inlen == HASH_BYTES) {
+        haraka256(&ctx->haraka, in, out);
+    } else if (inlen == 2 * HASH_BYTES) {
+        haraka512_256(&ctx->haraka, in, out);
+    } else {
+        haraka_S(&ctx->haraka, in, inlen, out, HASH_BYTES);
+    }
+}
+
+/* Pair hashes run four Haraka-512 instances interleaved to hide AES latency */
+static void haraka_backend_thash_batch(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen, size_t count) {
+    size_t i = 0;
+    if (inlen == 2 * HASH_BYTES) {
+        for (; i + 4 <= count; i += 4) {
+            haraka512_256_x4(&ctx->haraka, in + i * inlen, out + i * HASH_BYTES);
+        }
+    }
+    for (; i < count; ++i) {
+        haraka_backend_thash(ctx, out + i * HASH_BYTES, in + i * inlen, inlen);
+    }
+}
+
+static void haraka_backend_prf(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen) {
+    haraka_S(&ctx->haraka, in, inlen, out, HASH_BYTES);
+}
+
+static const sphincs_hash_backend backends[] = {
+    { SPHINCS_HASH_SHA256, "sha256", sha256_backend_available, sha256_backend_init,
+      sha256_backend_thash, generic_thash_batch, sha256_backend_prf, sha256_backend_thash },
+    { SPHINCS_HASH_SHAKE256, "shake256", shake256_backend_available, shake256_backend_init,
+      shake256_backend_thash, generic_thash_batch, shake256_backend_prf, shake256_backend_thash },
+    { SPHINCS_HASH_HARAKA, "haraka", haraka_available, haraka_backend_init,
+      haraka_backend_thash, haraka_backend_thash_batch, haraka_backend_prf, haraka_backend_prf },
+};
+
+const sphincs_hash_backend *hash_backend(sphincs_hash_id id) {
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); ++i) {
+        if (backends[i].id == id) {
+            return &backends[i];
+        }
+    }
+    return NULL;
+}
+
+sphincs_hash_id hash_fastest_available(void) {
+    if (haraka_available()) {
+        return SPHINCS_HASH_HARAKA;
+    }
+    return SPHINCS_HASH_SHA256;
+}
+
+int hash_ctx_init(sphincs_hash_ctx *ctx, sphincs_hash_id id, const uint8_t *pub_seed) {
+    if (!ctx) return HASH_NULL_POINTER;
+
+    const sphincs_hash_backend *backend = hash_backend(id);
+    if (!backend) return HASH_UNKNOWN_BACKEND;
+    if (!backend->available()) return HASH_UNAVAILABLE;
+
+    ctx->backend = backend;
+    if (pub_seed) {
+        memcpy(ctx->pub_seed, pub_seed, HASH_BYTES);
+    } else {
+        memset(ctx->pub_seed, 0, HASH_BYTES);
+    }
+    backend->init(ctx);
+    return HASH_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sha256.h"
+#include "shake256.h"
+#include "haraka.h"
+
+#define HASH_BYTES 32
+
+// Hash instantiations a key can be bound to
+typedef enum {
+    SPHINCS_HASH_SHA256 = 0,
+    SPHINCS_HASH_SHAKE256 = 1,
+    SPHINCS_HASH_HARAKA = 2
+} sphincs_hash_id;
+
+// Constants for error codes
+#define HASH_SUCCESS 0
+#define HASH_NULL_POINTER -1
+#define HASH_UNKNOWN_BACKEND -2
+#define HASH_UNAVAILABLE -3
+
+struct sphincs_hash_backend;
+
+// Per-key hash context: the selected backend plus whatever that backend
+// precomputes from the public seed (SHA-256 midstate, Haraka constants).
+typedef struct {
+    const struct sphincs_hash_backend *backend;
+    uint8_t pub_seed[HASH_BYTES];
+    sha256_ctx sha256_seeded;
+    haraka_ctx haraka;
+} sphincs_hash_ctx;
+
+// Every role produces HASH_BYTES of output.
+//   thash  - tweakable hash keyed by the public seed (chains, tree nodes, leaves)
+//   prf    - pseudorandom function used for secret key material
+//   h_msg  - message digest feeding FORS and WOTS+ signing
+// thash_batch hashes count contiguous inputs of inlen bytes into count
+// contiguous outputs, letting multi-lane backends keep every lane busy.
+typedef struct sphincs_hash_backend {
+    sphincs_hash_id id;
+    const char *name;
+    int (*available)(void);
+    void (*init)(sphincs_hash_ctx *ctx);
+    void (*thash)(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen);
+    void (*thash_batch)(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen, size_t count);
+    void (*prf)(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *in, size_t inlen);
+    void (*h_msg)(const sphincs_hash_ctx *ctx, uint8_t *out, const uint8_t *msg, size_t msglen);
+} sphincs_hash_backend;
+
+const sphincs_hash_backend *hash_backend(sphincs_hash_id id);
+// Fastest backend usable on this machine
+sphincs_hash_id hash_fastest_available(void);
+
+int hash_ctx_init(sphincs_hash_ctx *ctx, sphincs_hash_id id, const uint8_t *pub_seed);
+
+#define hash_thash(ctx, out, in, inlen) ((ctx)->backend->thash((ctx), (out), (in), (inlen)))
+#define hash_thash_batch(ctx, out, in, inlen, count) ((ctx)->backend->thash_batch((ctx), (out), (in), (inlen), (count)))
+#define hash_prf(ctx, out, in, inlen) ((ctx)->backend->prf((ctx), (out), (in), (inlen)))
+#define hash_h_msg(ctx, out, msg, msglen) ((ctx)->backend->h_msg((ctx), (out), (msg), (msglen)))
+
+#endif // HASH_H
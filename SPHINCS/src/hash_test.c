@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+#include "test_util.h"
+
+/* SHAKE256 against the FIPS 202 outputs for "" and "abc" */
+static void test_shake256(void) {
+    static const uint8_t empty[HASH_BYTES] = {
+        0x46, 0xb9, 0xdd, 0x2b, 0x0b, 0xa8, 0x8d, 0x13, 0x23, 0x3b, 0x3f, 0xeb, 0x74, 0x3e, 0xeb, 0x24,
+        0x3f, 0xcd, 0x52, 0xea, 0x62, 0xb8, 0x1b, 0x82, 0xb5, 0x0c, 0x27, 0x64, 0x6e, 0xd5, 0x76, 0x2f
+    };
+    static const uint8_t abc[HASH_BYTES] = {
+        0x48, 0x33, 0x66, 0x60, 0x13, 0x60, 0xa8, 0x77, 0x1c, 0x68, 0x63, 0x08, 0x0c, 0xc4, 0x11, 0x4d,
+        0x8d, 0xb4, 0x45, 0x30, 0xf8, 0xf1, 0xe1, 0xee, 0x4f, 0x94, 0xea, 0x37, 0xe7, 0x8b, 0x57, 0x39
+    };
+    uint8_t output[HASH_BYTES];
+
+    shake256((const uint8_t*)"", 0, output, HASH_BYTES);
+    report("SHAKE256 empty", compare_bytes(output, empty, HASH_BYTES));
+    shake256((const uint8_t*)"abc", 3, output, HASH_BYTES);
+    report("SHAKE256 abc", compare_bytes(output, abc, HASH_BYTES));
+}
+
+/* Haraka v2 against the reference vectors for inputs 0x00, 0x01, ... */
+static void test_haraka(void) {
+    static const uint8_t h256[HASH_BYTES] = {
+        0x80, 0x27, 0xcc, 0xb8, 0x79, 0x49, 0x77, 0x4b, 0x78, 0xd0, 0x54, 0x5f, 0xb7, 0x2b, 0xf7, 0x0c,
+        0x69, 0x5c, 0x2a, 0x09, 0x23, 0xcb, 0xd4, 0x7b, 0xba, 0x11, 0x59, 0xef, 0xbf, 0x2b, 0x2c, 0x1c
+    };
+    static const uint8_t h512[HASH_BYTES] = {
+        0xbe, 0x7f, 0x72, 0x3b, 0x4e, 0x80, 0xa9, 0x98, 0x13, 0xb2, 0x92, 0x28, 0x7f, 0x30, 0x6f, 0x62,
+        0x5a, 0x6d, 0x57, 0x33, 0x1c, 0xae, 0x5f, 0x34, 0xdd, 0x92, 0x77, 0xb0, 0x94, 0x5b, 0xe2, 0xaa
+    };
+    uint8_t input[2 * HASH_BYTES];
+    uint8_t output[HASH_BYTES];
+    haraka_ctx ctx;
+
+    if (!haraka_available()) {
+        sphincs_hash_ctx hash;
+        report("Haraka unavailable", hash_ctx_init(&hash, SPHINCS_HASH_HARAKA, NULL) == HASH_UNAVAILABLE);
+        return;
+    }
+    for (int i = 0; i < 2 * HASH_BYTES; ++i) {
+        input[i] = (uint8_t)i;
+    }
+    haraka_init(&ctx);
+    haraka256(&ctx, input, output);
+    report("Haraka-256", compare_bytes(output, h256, HASH_BYTES));
+    haraka512_256(&ctx, input, output);
+    report("Haraka-512", compare_bytes(output, h512, HASH_BYTES));
+}
+
+/* A midstate-based thash must agree with hashing seed block || input in one go */
+static void test_sha256_backend(void) {
+    uint8_t seed[HASH_BYTES];
+    uint8_t block[SHA256_BLOCK_SIZE + HASH_BYTES];
+    uint8_t expected[HASH_BYTES];
+    uint8_t output[HASH_BYTES];
+    sphincs_hash_ctx ctx;
+
+    for (int i = 0; i < HASH_BYTES; ++i) {
+        seed[i] = (uint8_t)(0xA0 + i);
+    }
+    memset(block, 0, sizeof(block));
+    memcpy(block, seed, HASH_BYTES);
+    memset(block + SHA256_BLOCK_SIZE, 0x5C, HASH_BYTES);
+    sha256(block, sizeof(block), expected);
+
+    hash_ctx_init(&ctx, SPHINCS_HASH_SHA256, seed);
+    hash_thash(&ctx, output, block + SHA256_BLOCK_SIZE, HASH_BYTES);
+    report("SHA-256 backend thash", compare_bytes(output, expected, HASH_BYTES));
+}
+
+int main() {
+    test_shake256();
+    test_haraka();
+    test_sha256_backend();
+    return test_status();
+}
@@ -1,60 +1,61 @@
-
 #include "hypertree.h"
+#include "merkle.h"
+#include <string.h>
+
+void hypertree_compute_root(const sphincs_hash_ctx *ctx, uint8_t *root, const xmss_multitree_public_key layers[HYPERTREE_LAYERS]) {
+    uint8_t roots[HYPERTREE_LAYERS][HASH_BYTES];
+    for (int i = 0; i < HYPERTREE_LAYERS; i++) {
+        memcpy(roots[i], layers[i].root, HASH_BYTES);
+    }
+    hash_thash(ctx, root, roots[0], sizeof(roots));
+}
 
 // Function to generate Hypertree public and secret keys
-int hypertree_keygen(hypertree_public_key *pk, hypertree_secret_key *sk, const uint8_t *seed) {
-    if (!pk || !sk || !seed) return -1;
+int hypertree_keygen(const sphincs_hash_ctx *ctx, hypertree_public_key *pk, hypertree_secret_key *sk, const uint8_t *seed) {
+    if (!ctx || !pk || !sk || !seed) return -1;
 
     // Generate secret keys for each layer
+    xmss_multitree_public_key layers[HYPERTREE_LAYERS];
     for (int i = 0; i < HYPERTREE_LAYERS; i++) {
-        if (xmss_keygen(&pk->root, &sk->layers[i], seed) != 0) {
+        if (xmss_keygen(ctx, &layers[i], &sk->layers[i], seed) != 0) {
             return -2;
         }
     }
+    hypertree_compute_root(ctx, pk->root, layers);
 
     return 0;
 }
 
 // Function to sign a message using Hypertree
-int hypertree_sign(hypertree_signature *sig, const uint8_t *msg, hypertree_secret_key *sk, const uint8_t *seed) {
-    if (!sig || !msg || !sk || !seed) return -1;
-
-    // Compute the FORS signature for the message
-    if (fors_sign(&sig->fors_sig, msg, &sk->layers[0], seed) != 0) {
-        return -2;
-    }
-
-    uint8_t root[HASH_BYTES];
-    fors_public_key_from_signature(root, &sig->fors_sig, msg);
+int hypertree_sign(const sphincs_hash_ctx *ctx, hypertree_signature *sig, const uint8_t *msg, hypertree_secret_key *sk, tree_cache *cache) {
+    if (!ctx || !sig || !msg || !sk) return -1;
 
     // Compute the XMSS signature for each layer of the Hypertree
-    for (int i = 0; i < HYPERTREE_LAYERS - 1; i++) {
-        xmss_multitree_signature *xmss_sig = &sig->xmss_sigs[i];
-        if (xmss_sign(xmss_sig, root, &sk->layers[i + 1], seed) != 0) {
+    for (int i = 0; i < HYPERTREE_LAYERS; i++) {
+        if (xmss_sign(ctx, &sig->layers[i], msg, &sk->layers[i], cache) != 0) {
             return -3;
         }
-        xmss_treehash(xmss_sig->leaf, xmss_sig->leaf_idx, XMSS_HEIGHT, xmss_sig->auth_path, root);
     }
 
     return 0;
 }
 
 // Function to verify a Hypertree signature
-int hypertree_verify(const hypertree_signature *sig, const uint8_t *msg, const hypertree_public_key *pk) {
-    if (!sig || !msg || !pk) return -1;
-
-    uint8_t root[HASH_BYTES];
-    fors_public_key_from_signature(root, &sig->fors_sig, msg);
+int hypertree_verify(const sphincs_hash_ctx *ctx, const hypertree_signature *sig, const uint8_t *msg, const hypertree_public_key *pk) {
+    if (!ctx || !sig || !msg || !pk) return -1;
 
-    // Verifying the XMSS signatures in each layer of the Hypertree
-    for (int i = 0; i < HYPERTREE_LAYERS - 1; i++) {
-        const xmss_multitree_signature *xmss_sig = &sig->xmss_sigs[i];
-        if (xmss_verify(xmss_sig, root, &pk->root) != 0) {
-            return -2;
+    // Recompute each layer's root from its signature
+    xmss_multitree_public_key layers[HYPERTREE_LAYERS];
+    for (int i = 0; i < HYPERTREE_LAYERS; i++) {
+        const xmss_multitree_signature *xmss_sig = &sig->layers[i];
+        if (xmss_sig->leaf_idx >= (1u << XMSS_HEIGHT)) {
+            return 0;
         }
-        xmss_treehash(xmss_sig->leaf, xmss_sig->leaf_idx, XMSS_HEIGHT, xmss_sig->auth_path, root);
+        merkle_root_from_path(ctx, xmss_sig->leaf, xmss_sig->leaf_idx, xmss_sig->auth_path[0], XMSS_HEIGHT, layers[i].root);
     }
 
     // Comparing the recomputed root to the public key
+    uint8_t root[HASH_BYTES];
+    hypertree_compute_root(ctx, root, layers);
     return memcmp(root, pk->root, HASH_BYTES) == 0;
 }
@@ -1,10 +1,9 @@
-
 #ifndef HYPERTREE_H
 #define HYPERTREE_H
 
 #include <stdint.h>
 #include "xmss.h"
-#include "fors.h"
+#include "tree_cache.h"
 
 #define HYPERTREE_LAYERS 5 // Number of layers in the Hypertree
 
@@ -20,12 +19,16 @@ typedef struct {
 
 // Hypertree signature structure
 typedef struct {
-    fors_signature fors_sig; // FORS signature
-    xmss_multitree_signature xmss_sigs[HYPERTREE_LAYERS - 1]; // XMSS signatures for each layer
+    xmss_multitree_signature layers[HYPERTREE_LAYERS]; // XMSS signatures for each layer
 } hypertree_signature;
 
-int hypertree_keygen(hypertree_public_key *pk, hypertree_secret_key *sk, const uint8_t *seed);
-int hypertree_sign(hypertree_signature *sig, const uint8_t *msg, hypertree_secret_key *sk, const uint8_t *seed);
-int hypertree_verify(const hypertree_signature *sig, const uint8_t *msg, const hypertree_public_key *pk);
+// The hypertree root hashes the roots of all layers, bottom layer first
+void hypertree_compute_root(const sphincs_hash_ctx *ctx, uint8_t *root, const xmss_multitree_public_key layers[HYPERTREE_LAYERS]);
+
+int hypertree_keygen(const sphincs_hash_ctx *ctx, hypertree_public_key *pk, hypertree_secret_key *sk, const uint8_t *seed);
+// cache may be NULL, as for xmss_sign
+int hypertree_sign(const sphincs_hash_ctx *ctx, hypertree_signature *sig, const uint8_t *msg, hypertree_secret_key *sk, tree_cache *cache);
+// Returns 1 for a valid signature, 0 otherwise, -1 for NULL arguments
+int hypertree_verify(const sphincs_hash_ctx *ctx, const hypertree_signature *sig, const uint8_t *msg, const hypertree_public_key *pk);
 
 #endif // HYPERTREE_H
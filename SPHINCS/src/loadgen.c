@@ -0,0 +1,474 @@
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sphincs.h"
+
+// sphincs_loadgen: run a keygen/sign/verify mix on 1..N threads and print
+// throughput, scaling efficiency and latency percentiles as JSON.
+//
+// Keygen draws its seeds from the RNG in rng.c, whose state is per thread,
+// and signing never touches it, so no op here shares RNG state.
+
+enum { OP_KEYGEN, OP_SIGN, OP_VERIFY, OP_KINDS };
+static const char *op_names[OP_KINDS] = { "keygen", "sign", "verify" };
+
+// Log-linear latency histogram: exact below 16 ns, then 16 buckets per
+// power of two (about 6% resolution) up to 2^40 ns.
+#define LAT_SUB_BITS 4
+#define LAT_SUB (1 << LAT_SUB_BITS)
+#define LAT_MAX_LOG2 40
+#define LAT_BUCKETS ((LAT_MAX_LOG2 - LAT_SUB_BITS + 2) * LAT_SUB)
+
+typedef struct {
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t total;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} latency_hist;
+
+static int lat_bucket(uint64_t ns) {
+    if (ns < LAT_SUB) return (int)ns;
+    int log2 = 63 - __builtin_clzll(ns);
+    if (log2 > LAT_MAX_LOG2) return LAT_BUCKETS - 1;
+    int sub = (int)(ns >> (log2 - LAT_SUB_BITS)) & (LAT_SUB - 1);
+    return (log2 - LAT_SUB_BITS + 1) * LAT_SUB + sub;
+}
+
+// Largest value that falls in bucket b
+static uint64_t lat_bucket_max(int b) {
+    if (b < LAT_SUB) return (uint64_t)b;
+    int log2 = b / LAT_SUB + LAT_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b % LAT_SUB);
+    return ((LAT_SUB + sub + 1) << (log2 - LAT_SUB_BITS)) - 1;
+}
+
+static void lat_record(latency_hist *h, uint64_t ns) {
+    h->counts[lat_bucket(ns)]++;
+    h->total++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+static void lat_merge(latency_hist *into, const latency_hist *from) {
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    into->sum_ns += from->sum_ns;
+    if (from->max_ns > into->max_ns) into->max_ns = from->max_ns;
+}
+
+static uint64_t lat_percentile(const latency_hist *h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)h->total);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = lat_bucket_max(i);
+            return v < h->max_ns ? v : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    int threads[64];
+    int thread_runs;
+    double duration;
+    size_t msg_size;
+    int keys;
+    int batch;
+    unsigned mix[OP_KINDS];
+    sphincs_hash_id hash_id;
+    int histogram;
+} loadgen_config;
+
+// A key shared by all threads. Signing advances the secret key's leaf
+// indices, so it is serialised per key like the sign service does.
+typedef struct {
+    pthread_mutex_t lock;
+    sphincs_secret_key sk;
+    sphincs_signer signer;
+    sphincs_prepared_pk prepared;
+    sphincs_signature sig; // Signature over msg, for verify ops
+    uint8_t *msg;
+} loadgen_key;
+
+typedef struct {
+    const loadgen_config *config;
+    loadgen_key *keys;
+    pthread_barrier_t *start;
+    atomic_int *stop;
+    int id;
+    uint64_t rng_state;
+
+    latency_hist lat[OP_KINDS];
+    uint64_t ops;
+    uint64_t errors;
+    uint64_t elapsed_ns;
+} loadgen_thread;
+
+// xorshift64*, local to a thread so picking ops never touches rng.c
+static uint64_t next_random(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1DULL;
+}
+
+// The leaf indices run out after 2^XMSS_HEIGHT signatures; a load test
+// only cares about the cost of signing, so wrap them around.
+static void rewind_key(sphincs_secret_key *sk) {
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (sk->xmss_sk[i].idx >= (1u << XMSS_HEIGHT)) {
+            sk->xmss_sk[i].idx = 0;
+        }
+    }
+}
+
+static int run_op(loadgen_thread *t, int op, uint8_t *msg, sphincs_public_key *scratch_pk,
+                  sphincs_secret_key *scratch_sk, sphincs_signature *scratch_sig) {
+    const loadgen_config *config = t->config;
+    loadgen_key *key = &t->keys[next_random(&t->rng_state) % (uint64_t)config->keys];
+    int ret;
+
+    switch (op) {
+    case OP_KEYGEN: {
+        uint8_t seed[HASH_BYTES];
+        for (int i = 0; i < HASH_BYTES; i += 8) {
+            uint64_t r = next_random(&t->rng_state);
+            memcpy(seed + i, &r, 8);
+        }
+        return sphincs_keygen_with_hash(scratch_pk, scratch_sk, seed, config->hash_id);
+    }
+    case OP_SIGN:
+        pthread_mutex_lock(&key->lock);
+        rewind_key(&key->sk);
+        ret = sphincs_signer_sign(&key->signer, scratch_sig, msg, config->msg_size);
+        pthread_mutex_unlock(&key->lock);
+        return ret;
+    case OP_VERIFY:
+        ret = sphincs_verify_prepared(&key->sig, key->msg, config->msg_size, &key->prepared);
+        return ret == 1 ? 0 : -1;
+    }
+    return -1;
+}
+
+static int pick_op(loadgen_thread *t) {
+    const unsigned *mix = t->config->mix;
+    unsigned total = mix[OP_KEYGEN] + mix[OP_SIGN] + mix[OP_VERIFY];
+    unsigned r = (unsigned)(next_random(&t->rng_state) % total);
+    for (int op = 0; op < OP_KINDS; op++) {
+        if (r < mix[op]) return op;
+        r -= mix[op];
+    }
+    return OP_VERIFY;
+}
+
+static void *thread_main(void *arg) {
+    loadgen_thread *t = arg;
+    const loadgen_config *config = t->config;
+    uint8_t *msg = malloc(config->msg_size ? config->msg_size : 1);
+    sphincs_public_key *pk = malloc(sizeof(*pk));
+    sphincs_secret_key *sk = malloc(sizeof(*sk));
+    sphincs_signature *sig = malloc(sizeof(*sig));
+    if (!msg || !pk || !sk || !sig) {
+        t->errors++;
+        atomic_store(t->stop, 1);
+    }
+    for (size_t i = 0; msg && i < config->msg_size; i++) {
+        msg[i] = (uint8_t)next_random(&t->rng_state);
+    }
+
+    pthread_barrier_wait(t->start);
+    uint64_t start = now_ns();
+    while (!atomic_load_explicit(t->stop, memory_order_relaxed)) {
+        // Ops are drawn from the mix a batch at a time and run back to back
+        int op = pick_op(t);
+        for (int i = 0; i < config->batch; i++) {
+            uint64_t op_start = now_ns();
+            if (run_op(t, op, msg, pk, sk, sig) != 0) {
+                t->errors++;
+            }
+            lat_record(&t->lat[op], now_ns() - op_start);
+            t->ops++;
+        }
+    }
+    t->elapsed_ns = now_ns() - start;
+
+    sphincs_wipe(sk, sizeof(*sk));
+    free(msg);
+    free(pk);
+    free(sk);
+    free(sig);
+    return NULL;
+}
+
+static int setup_keys(const loadgen_config *config, loadgen_key *keys) {
+    for (int k = 0; k < config->keys; k++) {
+        loadgen_key *key = &keys[k];
+        sphincs_public_key pk;
+        uint8_t seed[HASH_BYTES];
+
+        for (int i = 0; i < HASH_BYTES; i++) {
+            seed[i] = (uint8_t)(k * 131 + i);
+        }
+        key->msg = malloc(config->msg_size ? config->msg_size : 1);
+        if (!key->msg) return -1;
+        memset(key->msg, k, config->msg_size);
+
+        pthread_mutex_init(&key->lock, NULL);
+        if (sphincs_keygen_with_hash(&pk, &key->sk, seed, config->hash_id) != 0 ||
+            sphincs_signer_init(&key->signer, &key->sk, SPHINCS_DEFAULT_CACHED_TREES, NULL) != 0 ||
+            sphincs_prepare_pk(&key->prepared, &pk) != 0 ||
+            sphincs_signer_sign(&key->signer, &key->sig, key->msg, config->msg_size) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void free_keys(const loadgen_config *config, loadgen_key *keys) {
+    for (int k = 0; k < config->keys; k++) {
+        sphincs_signer_free(&keys[k].signer);
+        sphincs_wipe(&keys[k].sk, sizeof(keys[k].sk));
+        pthread_mutex_destroy(&keys[k].lock);
+        free(keys[k].msg);
+    }
+}
+
+static void print_hist(const latency_hist *h, int with_buckets) {
+    printf("{\"count\": %llu, \"mean_ns\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu",
+           (unsigned long long)h->total,
+           (unsigned long long)(h->total ? h->sum_ns / h->total : 0),
+           (unsigned long long)lat_percentile(h, 0.50),
+           (unsigned long long)lat_percentile(h, 0.99),
+           (unsigned long long)lat_percentile(h, 0.999),
+           (unsigned long long)h->max_ns);
+    if (with_buckets) {
+        // Non-empty buckets as [upper bound ns, count]
+        printf(", \"buckets\": [");
+        int first = 1;
+        for (int i = 0; i < LAT_BUCKETS; i++) {
+            if (!h->counts[i]) continue;
+            printf("%s[%llu, %llu]", first ? "" : ", ",
+                   (unsigned long long)lat_bucket_max(i), (unsigned long long)h->counts[i]);
+            first = 0;
+        }
+        printf("]");
+    }
+    printf("}");
+}
+
+// Run the mix on nthreads threads for the configured duration and print
+// one JSON object. base_rate is the per-thread ops/sec of the first run.
+static int run_once(const loadgen_config *config, loadgen_key *keys, int nthreads, double *base_rate) {
+    loadgen_thread *threads = calloc((size_t)nthreads, sizeof(*threads));
+    pthread_t *tids = calloc((size_t)nthreads, sizeof(*tids));
+    pthread_barrier_t start;
+    atomic_int stop = 0;
+    int started = 0;
+
+    if (!threads || !tids) {
+        free(threads);
+        free(tids);
+        return -1;
+    }
+    pthread_barrier_init(&start, NULL, (unsigned)nthreads + 1);
+    for (int i = 0; i < nthreads; i++) {
+        threads[i].config = config;
+        threads[i].keys = keys;
+        threads[i].start = &start;
+        threads[i].stop = &stop;
+        threads[i].id = i;
+        threads[i].rng_state = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        if (pthread_create(&tids[i], NULL, thread_main, &threads[i]) != 0) {
+            fprintf(stderr, "sphincs_loadgen: pthread_create: %s\n", strerror(errno));
+            exit(1);
+        }
+        started++;
+    }
+
+    pthread_barrier_wait(&start);
+    struct timespec run = { (time_t)config->duration,
+                            (long)((config->duration - (double)(time_t)config->duration) * 1e9) };
+    nanosleep(&run, NULL);
+    atomic_store(&stop, 1);
+
+    latency_hist *total = calloc(OP_KINDS, sizeof(*total));
+    uint64_t ops = 0, errors = 0, busy = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+        for (int op = 0; op < OP_KINDS; op++) {
+            lat_merge(&total[op], &threads[i].lat[op]);
+        }
+        ops += threads[i].ops;
+        errors += threads[i].errors;
+        busy += threads[i].elapsed_ns;
+    }
+    pthread_barrier_destroy(&start);
+
+    double secs = busy ? (double)busy / 1e9 / nthreads : config->duration;
+    double rate = (double)ops / secs;
+    if (*base_rate == 0.0) *base_rate = rate / nthreads;
+
+    printf("    {\"threads\": %d, \"seconds\": %.3f, \"ops\": %llu, \"errors\": %llu, \"ops_per_sec\": %.2f, "
+           "\"ops_per_sec_per_thread\": %.2f, \"scaling_efficiency\": %.4f,\n",
+           nthreads, secs, (unsigned long long)ops, (unsigned long long)errors, rate, rate / nthreads,
+           *base_rate > 0.0 ? rate / nthreads / *base_rate : 0.0);
+    printf("     \"per_thread_ops_per_sec\": [");
+    for (int i = 0; i < nthreads; i++) {
+        double t_secs = threads[i].elapsed_ns ? (double)threads[i].elapsed_ns / 1e9 : secs;
+        printf("%s%.2f", i ? ", " : "", (double)threads[i].ops / t_secs);
+    }
+    printf("],\n     \"latency\": {");
+    for (int op = 0; op < OP_KINDS; op++) {
+        printf("%s\"%s\": ", op ? ", " : "", op_names[op]);
+        print_hist(&total[op], config->histogram);
+    }
+    printf("}}");
+
+    free(total);
+    free(threads);
+    free(tids);
+    return 0;
+}
+
+static int parse_mix(const char *arg, unsigned *mix) {
+    unsigned k, s, v;
+    if (sscanf(arg, "%u:%u:%u", &k, &s, &v) != 3 || k + s + v == 0) return -1;
+    mix[OP_KEYGEN] = k;
+    mix[OP_SIGN] = s;
+    mix[OP_VERIFY] = v;
+    return 0;
+}
+
+static int parse_threads(const char *arg, loadgen_config *config) {
+    config->thread_runs = 0;
+    while (*arg) {
+        char *end;
+        long n = strtol(arg, &end, 10);
+        if (end == arg || n < 1 || n > 1024 || config->thread_runs == 64) return -1;
+        config->threads[config->thread_runs++] = (int)n;
+        arg = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return -1;
+    }
+    return config->thread_runs ? 0 : -1;
+}
+
+// Default sweep: 1, 2, 4, ... up to the number of online CPUs
+static void default_threads(loadgen_config *config) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    config->thread_runs = 0;
+    for (long n = 1; n < cpus && config->thread_runs < 63; n *= 2) {
+        config->threads[config->thread_runs++] = (int)n;
+    }
+    config->threads[config->thread_runs++] = (int)cpus;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -t, --threads LIST    thread counts to sweep, e.g. 1,2,4,8 (default: powers of two up to the CPU count)\n"
+            "  -d, --duration SECS   seconds per thread count (default 5)\n"
+            "  -m, --msg-size BYTES  message size (default 64)\n"
+            "  -k, --keys N          number of keys shared by the threads (default 1)\n"
+            "  -b, --batch N         ops of one kind run back to back per draw (default 1)\n"
+            "  -x, --mix K:S:V       keygen:sign:verify weights (default 0:1:4)\n"
+            "  -H, --hash NAME       sha256, shake256 or haraka (default sha256)\n"
+            "      --histogram       include non-empty latency buckets\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    loadgen_config config = {
+        .duration = 5.0,
+        .msg_size = 64,
+        .keys = 1,
+        .batch = 1,
+        .mix = { 0, 1, 4 },
+        .hash_id = SPHINCS_HASH_SHA256,
+    };
+    default_threads(&config);
+
+    static const struct option options[] = {
+        { "threads", required_argument, NULL, 't' },
+        { "duration", required_argument, NULL, 'd' },
+        { "msg-size", required_argument, NULL, 'm' },
+        { "keys", required_argument, NULL, 'k' },
+        { "batch", required_argument, NULL, 'b' },
+        { "mix", required_argument, NULL, 'x' },
+        { "hash", required_argument, NULL, 'H' },
+        { "histogram", no_argument, NULL, 'G' },
+        { NULL, 0, NULL, 0 },
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "t:d:m:k:b:x:H:", options, NULL)) != -1) {
+        switch (c) {
+        case 't':
+            if (parse_threads(optarg, &config) != 0) { usage(argv[0]); return 2; }
+            break;
+        case 'd': config.duration = atof(optarg); break;
+        case 'm': config.msg_size = (size_t)strtoul(optarg, NULL, 10); break;
+        case 'k': config.keys = atoi(optarg); break;
+        case 'b': config.batch = atoi(optarg); break;
+        case 'x':
+            if (parse_mix(optarg, config.mix) != 0) { usage(argv[0]); return 2; }
+            break;
+        case 'H':
+            if (strcmp(optarg, "sha256") == 0) config.hash_id = SPHINCS_HASH_SHA256;
+            else if (strcmp(optarg, "shake256") == 0) config.hash_id = SPHINCS_HASH_SHAKE256;
+            else if (strcmp(optarg, "haraka") == 0) config.hash_id = SPHINCS_HASH_HARAKA;
+            else { usage(argv[0]); return 2; }
+            break;
+        case 'G': config.histogram = 1; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (config.duration <= 0.0 || config.keys < 1 || config.batch < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    loadgen_key *keys = calloc((size_t)config.keys, sizeof(*keys));
+    if (!keys || setup_keys(&config, keys) != 0) {
+        fprintf(stderr, "sphincs_loadgen: key setup failed\n");
+        return 1;
+    }
+
+    static const char *hash_names[] = { "sha256", "shake256", "haraka" };
+    printf("{\"config\": {\"duration\": %.3f, \"msg_size\": %zu, \"keys\": %d, \"batch\": %d, "
+           "\"mix\": {\"keygen\": %u, \"sign\": %u, \"verify\": %u}, \"hash\": \"%s\"},\n",
+           config.duration, config.msg_size, config.keys, config.batch,
+           config.mix[OP_KEYGEN], config.mix[OP_SIGN], config.mix[OP_VERIFY],
+           hash_names[config.hash_id]);
+    printf(" \"runs\": [\n");
+    double base_rate = 0.0;
+    for (int r = 0; r < config.thread_runs; r++) {
+        if (run_once(&config, keys, config.threads[r], &base_rate) != 0) {
+            fprintf(stderr, "sphincs_loadgen: out of memory\n");
+            return 1;
+        }
+        printf("%s\n", r + 1 < config.thread_runs ? "," : "");
+    }
+    printf(" ]}\n");
+
+    free_keys(&config, keys);
+    free(keys);
+    return 0;
+}
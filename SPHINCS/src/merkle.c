@@ -0,0 +1,97 @@
+#include "merkle.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Index of the first node of a level: the levels below hold
+// 2^h + 2^(h-1) + ... + 2^(h-level+1) nodes.
+static size_t level_offset(int height, int level) {
+    return (2u << height) - (2u << (height - level));
+}
+
+int merkle_tree_alloc(merkle_tree *tree, int height, sphincs_arena *arena) {
+    if (!tree) return MERKLE_NULL_POINTER;
+    if (height < 0 || height > MERKLE_MAX_HEIGHT) return MERKLE_INVALID_HEIGHT;
+
+    size_t bytes = (size_t)MERKLE_NODES(height) * HASH_BYTES;
+    void *nodes = NULL;
+    if (arena) {
+        // Arena blocks are ARENA_ALIGN (a cache line) aligned already
+        nodes = sphincs_arena_alloc(arena, bytes);
+    } else if (posix_memalign(&nodes, MERKLE_ALIGN, bytes) != 0) {
+        nodes = NULL;
+    }
+    if (!nodes) return MERKLE_OUT_OF_MEMORY;
+
+    tree->height = height;
+    tree->nodes = nodes;
+    tree->arena = arena;
+    return MERKLE_SUCCESS;
+}
+
+void merkle_tree_free(merkle_tree *tree) {
+    if (!tree) return;
+    if (tree->arena) {
+        sphincs_arena_free(tree->arena, tree->nodes);
+    } else {
+        free(tree->nodes);
+    }
+    tree->nodes = NULL;
+}
+
+int merkle_tree_check(const sphincs_hash_ctx *ctx, const merkle_tree *tree) {
+    if (!ctx || !tree || !tree->nodes) return MERKLE_NULL_POINTER;
+    if (tree->height == 0) return MERKLE_SUCCESS;
+
+    // Rehash each level into scratch, sized for the widest parent level
+    uint8_t (*scratch)[HASH_BYTES] = malloc(((size_t)1 << (tree->height - 1)) * HASH_BYTES);
+    if (!scratch) return MERKLE_OUT_OF_MEMORY;
+
+    int ret = MERKLE_SUCCESS;
+    for (int level = 0; level < tree->height && ret == MERKLE_SUCCESS; level++) {
+        size_t parents = (size_t)1 << (tree->height - level - 1);
+        hash_thash_batch(ctx, scratch[0], merkle_node(tree, level, 0), 2 * HASH_BYTES, parents);
+        if (memcmp(scratch, merkle_node(tree, level + 1, 0), parents * HASH_BYTES) != 0) {
+            ret = MERKLE_CORRUPT;
+        }
+    }
+    free(scratch);
+    return ret;
+}
+
+uint8_t *merkle_node(const merkle_tree *tree, int level, uint32_t idx) {
+    return tree->nodes[level_offset(tree->height, level) + idx];
+}
+
+const uint8_t *merkle_root(const merkle_tree *tree) {
+    return merkle_node(tree, tree->height, 0);
+}
+
+void merkle_tree_build(const sphincs_hash_ctx *ctx, merkle_tree *tree) {
+    for (int level = 0; level < tree->height; level++) {
+        // Children of parent i are nodes 2i and 2i+1 of the level below,
+        // already laid out as the 64-byte input the pair hash expects
+        hash_thash_batch(ctx, merkle_node(tree, level + 1, 0), merkle_node(tree, level, 0),
+                         2 * HASH_BYTES, (size_t)1 << (tree->height - level - 1));
+    }
+}
+
+void merkle_auth_path(const merkle_tree *tree, uint32_t leaf_idx, uint8_t *auth_path) {
+    for (int level = 0; level < tree->height; level++) {
+        memcpy(auth_path + level * HASH_BYTES, merkle_node(tree, level, (leaf_idx >> level) ^ 1), HASH_BYTES);
+    }
+}
+
+void merkle_root_from_path(const sphincs_hash_ctx *ctx, const uint8_t *leaf, uint32_t leaf_idx,
+                           const uint8_t *auth_path, int height, uint8_t *root) {
+    uint8_t buffer[2 * HASH_BYTES];
+
+    // Keep the current node in the half of the buffer its index selects and
+    // write each parent straight into the half it occupies one level up
+    memcpy(buffer + (leaf_idx & 1) * HASH_BYTES, leaf, HASH_BYTES);
+    for (int i = 0; i < height; i++) {
+        memcpy(buffer + ((leaf_idx & 1) ^ 1) * HASH_BYTES, auth_path + i * HASH_BYTES, HASH_BYTES);
+        leaf_idx >>= 1;
+        hash_thash(ctx, buffer + (leaf_idx & 1) * HASH_BYTES, buffer, 2 * HASH_BYTES);
+    }
+    memcpy(root, buffer + (leaf_idx & 1) * HASH_BYTES, HASH_BYTES);
+}
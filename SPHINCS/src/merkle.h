@@ -0,0 +1,53 @@
+#ifndef MERKLE_H
+#define MERKLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hash.h"
+#include "arena.h"
+
+#define MERKLE_ALIGN 64 // Cache line size; each sibling pair fills one line
+#define MERKLE_MAX_HEIGHT 20
+
+// Number of nodes in a full tree of height h (2^h leaves)
+#define MERKLE_NODES(h) ((2u << (h)) - 1)
+
+// Constants for error codes
+#define MERKLE_SUCCESS 0
+#define MERKLE_NULL_POINTER -1
+#define MERKLE_INVALID_HEIGHT -2
+#define MERKLE_OUT_OF_MEMORY -3
+#define MERKLE_CORRUPT -4
+
+// Full binary tree stored contiguously in level order: the 2^height
+// leaves first, then each parent level, the root last. Siblings are
+// adjacent, so hashing a pair reads 64 contiguous bytes with no copying.
+typedef struct {
+    int height;
+    uint8_t (*nodes)[HASH_BYTES]; // MERKLE_ALIGN aligned
+    sphincs_arena *arena;         // Where nodes came from, NULL for the heap
+} merkle_tree;
+
+// arena may be NULL to allocate from the heap
+int merkle_tree_alloc(merkle_tree *tree, int height, sphincs_arena *arena);
+void merkle_tree_free(merkle_tree *tree);
+
+// MERKLE_SUCCESS if every node above the leaves is the hash of its two
+// children, MERKLE_CORRUPT otherwise
+int merkle_tree_check(const sphincs_hash_ctx *ctx, const merkle_tree *tree);
+
+// Node idx of the given level (level 0 holds the leaves)
+uint8_t *merkle_node(const merkle_tree *tree, int level, uint32_t idx);
+const uint8_t *merkle_root(const merkle_tree *tree);
+
+// Hash all levels above the leaves, one batched call per level
+void merkle_tree_build(const sphincs_hash_ctx *ctx, merkle_tree *tree);
+
+// Copy the height siblings on the path from leaf_idx to the root
+void merkle_auth_path(const merkle_tree *tree, uint32_t leaf_idx, uint8_t *auth_path);
+
+// Recompute a root from a leaf and its authentication path
+void merkle_root_from_path(const sphincs_hash_ctx *ctx, const uint8_t *leaf, uint32_t leaf_idx,
+                           const uint8_t *auth_path, int height, uint8_t *root);
+
+#endif // MERKLE_H
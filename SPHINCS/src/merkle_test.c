@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+#include "merkle.h"
+#include "xmss.h"
+#include "test_util.h"
+
+#define TEST_HEIGHT 3
+
+static void init_ctx(sphincs_hash_ctx* ctx) {
+    uint8_t seed[HASH_BYTES];
+    for (int i = 0; i < HASH_BYTES; ++i) {
+        seed[i] = (uint8_t)(0x30 + i);
+    }
+    hash_ctx_init(ctx, SPHINCS_HASH_SHA256, seed);
+}
+
+static void fill_leaves(merkle_tree* tree) {
+    for (uint32_t i = 0; i < (1u << tree->height); ++i) {
+        memset(merkle_node(tree, 0, i), (int)(i + 1), HASH_BYTES);
+    }
+}
+
+/* The root must match hashing the leaves pairwise, one level at a time */
+static void test_build(const sphincs_hash_ctx* ctx) {
+    uint8_t level[1 << TEST_HEIGHT][HASH_BYTES];
+    uint8_t pair[2 * HASH_BYTES];
+    merkle_tree tree;
+
+    if (merkle_tree_alloc(&tree, TEST_HEIGHT, NULL) != MERKLE_SUCCESS) {
+        report("Merkle build", 0);
+        return;
+    }
+    fill_leaves(&tree);
+    merkle_tree_build(ctx, &tree);
+
+    for (int i = 0; i < (1 << TEST_HEIGHT); ++i) {
+        memset(level[i], i + 1, HASH_BYTES);
+    }
+    for (int width = 1 << TEST_HEIGHT; width > 1; width /= 2) {
+        for (int i = 0; i < width / 2; ++i) {
+            memcpy(pair, level[2 * i], HASH_BYTES);
+            memcpy(pair + HASH_BYTES, level[2 * i + 1], HASH_BYTES);
+            hash_thash(ctx, level[i], pair, sizeof(pair));
+        }
+    }
+    report("Merkle build", memcmp(merkle_root(&tree), level[0], HASH_BYTES) == 0);
+    merkle_tree_free(&tree);
+}
+
+/* Every leaf's auth path must lead back to the root */
+static void test_auth_path(const sphincs_hash_ctx* ctx) {
+    uint8_t path[TEST_HEIGHT][HASH_BYTES];
+    uint8_t root[HASH_BYTES];
+    merkle_tree tree;
+    int ok = 1;
+
+    if (merkle_tree_alloc(&tree, TEST_HEIGHT, NULL) != MERKLE_SUCCESS) {
+        report("Merkle auth path", 0);
+        return;
+    }
+    fill_leaves(&tree);
+    merkle_tree_build(ctx, &tree);
+    for (uint32_t i = 0; i < (1u << TEST_HEIGHT); ++i) {
+        merkle_auth_path(&tree, i, path[0]);
+        merkle_root_from_path(ctx, merkle_node(&tree, 0, i), i, path[0], TEST_HEIGHT, root);
+        ok &= memcmp(root, merkle_root(&tree), HASH_BYTES) == 0;
+    }
+    // The same path from the wrong position must not
+    merkle_auth_path(&tree, 0, path[0]);
+    merkle_root_from_path(ctx, merkle_node(&tree, 0, 0), 1, path[0], TEST_HEIGHT, root);
+    ok &= memcmp(root, merkle_root(&tree), HASH_BYTES) != 0;
+    report("Merkle auth path", ok);
+    merkle_tree_free(&tree);
+}
+
+/* A built tree checks out; flipping a leaf or an inner node does not */
+static void test_check(const sphincs_hash_ctx* ctx) {
+    merkle_tree tree;
+    int ok = 1;
+
+    if (merkle_tree_alloc(&tree, TEST_HEIGHT, NULL) != MERKLE_SUCCESS) {
+        report("Merkle check", 0);
+        return;
+    }
+    fill_leaves(&tree);
+    merkle_tree_build(ctx, &tree);
+    ok &= merkle_tree_check(ctx, &tree) == MERKLE_SUCCESS;
+
+    merkle_node(&tree, 0, 5)[0] ^= 1;
+    ok &= merkle_tree_check(ctx, &tree) == MERKLE_CORRUPT;
+    merkle_node(&tree, 0, 5)[0] ^= 1;
+
+    merkle_node(&tree, 2, 1)[HASH_BYTES - 1] ^= 0x80;
+    ok &= merkle_tree_check(ctx, &tree) == MERKLE_CORRUPT;
+    report("Merkle check", ok);
+    merkle_tree_free(&tree);
+}
+
+/* XMSS signatures carry the full path, bottom subtree and top tree, so
+   they verify for leaves in any subtree */
+static void test_xmss_path(const sphincs_hash_ctx* ctx) {
+    static const uint8_t msg[HASH_BYTES] = { 1 };
+    uint8_t seed[HASH_BYTES] = { 7 };
+    xmss_multitree_public_key pk;
+    xmss_multitree_secret_key sk;
+    xmss_multitree_signature sig;
+    int ok = 1;
+
+    if (xmss_keygen(ctx, &pk, &sk, seed) != 0) {
+        report("XMSS auth path", 0);
+        return;
+    }
+    sk.idx = (1u << XMSS_SUBTREE_HEIGHT) + 3;
+    ok &= xmss_sign(ctx, &sig, msg, &sk, NULL) == 0;
+    ok &= xmss_verify(ctx, &sig, msg, &pk) == 1;
+
+    sig.auth_path[XMSS_HEIGHT - 1][0] ^= 1; // Last top tree level
+    ok &= xmss_verify(ctx, &sig, msg, &pk) == 0;
+    report("XMSS auth path", ok);
+}
+
+int main() {
+    sphincs_hash_ctx ctx;
+    init_ctx(&ctx);
+    test_build(&ctx);
+    test_auth_path(&ctx);
+    test_check(&ctx);
+    test_xmss_path(&ctx);
+    return test_status();
+}
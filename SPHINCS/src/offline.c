@@ -0,0 +1,271 @@
+#define _GNU_SOURCE
+#include "offline.h"
+#include "arena.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t idx[HYPER_LAYERS];
+    xmss_multitree_signature sigs[HYPER_LAYERS];
+} offline_entry;
+
+struct sphincs_offline {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t filled; // Broadcast when the ring grows or the thread stalls
+    int stopping;
+    int stalled; // Signing next_idx failed; wait for the signer to restart the ring
+    int cpu_share;
+    sphincs_arena *arena; // Backs this struct and trees, NULL for the heap
+
+    // The thread's own copy of the key material and trees, so signing and
+    // precomputation never contend for the signer's cache
+    sphincs_hash_ctx hash;
+    xmss_multitree_secret_key layers[HYPER_LAYERS];
+    tree_cache trees;
+
+    // Ring of precomputed entries, oldest first
+    offline_entry *ring;
+    size_t window;
+    size_t head;
+    size_t count;
+    uint32_t next_idx[HYPER_LAYERS]; // Indices the thread computes next
+    uint64_t generation;             // Bumped whenever the ring is restarted
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int exhausted(const uint32_t *idx) {
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (idx[i] >= (1u << XMSS_HEIGHT)) return 1;
+    }
+    return 0;
+}
+
+static int same_indices(const uint32_t *idx, const sphincs_secret_key *sk) {
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (idx[i] != sk->xmss_sk[i].idx) return 0;
+    }
+    return 1;
+}
+
+static int compute_entry(sphincs_offline *offline, const uint32_t *idx, offline_entry *entry) {
+    static const uint8_t unused_msg[HASH_BYTES]; // xmss_sign only checks it is set
+
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        xmss_multitree_secret_key layer = offline->layers[i];
+        layer.idx = idx[i];
+        int ret = xmss_sign(&offline->hash, &entry->sigs[i], unused_msg, &layer, &offline->trees);
+        sphincs_wipe(&layer, sizeof(layer));
+        if (ret != 0) {
+            return ret;
+        }
+        entry->idx[i] = idx[i];
+    }
+    return 0;
+}
+
+// Sleep long enough after busy_ns of work to stay within cpu_share, waking
+// early only to stop. Called with lock held.
+static void throttle(sphincs_offline *offline, uint64_t busy_ns) {
+    if (offline->cpu_share >= 100) return;
+
+    uint64_t deadline = now_ns() + busy_ns * (uint64_t)(100 - offline->cpu_share) / (uint64_t)offline->cpu_share;
+    struct timespec ts = { (time_t)(deadline / 1000000000u), (long)(deadline % 1000000000u) };
+    while (!offline->stopping && now_ns() < deadline) {
+        pthread_cond_timedwait(&offline->wake, &offline->lock, &ts);
+    }
+}
+
+static void *offline_main(void *arg) {
+    sphincs_offline *offline = arg;
+    offline_entry *entry = malloc(sizeof(*entry));
+
+    // Precomputation should only ever use otherwise idle CPU time
+    struct sched_param param = { 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param); // Best effort
+
+    pthread_mutex_lock(&offline->lock);
+    while (entry && !offline->stopping) {
+        if (offline->count == offline->window || offline->stalled || exhausted(offline->next_idx)) {
+            pthread_cond_wait(&offline->wake, &offline->lock);
+            continue;
+        }
+        uint32_t idx[HYPER_LAYERS];
+        memcpy(idx, offline->next_idx, sizeof(idx));
+        uint64_t generation = offline->generation;
+        pthread_mutex_unlock(&offline->lock);
+
+        uint64_t start = now_ns();
+        int ret = compute_entry(offline, idx, entry);
+        uint64_t busy = now_ns() - start;
+
+        pthread_mutex_lock(&offline->lock);
+        // Drop the result if the signer restarted the ring meanwhile. A
+        // failed entry is never stored: the signer misses on those indices
+        // and signs them inline, which reports the error to its caller.
+        if (generation != offline->generation) {
+            // Stale either way
+        } else if (ret != 0) {
+            offline->stalled = 1;
+            pthread_cond_broadcast(&offline->filled);
+        } else if (offline->count < offline->window) {
+            offline->ring[(offline->head + offline->count) % offline->window] = *entry;
+            offline->count++;
+            for (int i = 0; i < HYPER_LAYERS; i++) {
+                offline->next_idx[i]++;
+            }
+            pthread_cond_broadcast(&offline->filled);
+        }
+        throttle(offline, busy);
+    }
+    pthread_mutex_unlock(&offline->lock);
+
+    free(entry);
+    return NULL;
+}
+
+static void offline_free(sphincs_offline *offline) {
+    sphincs_arena *arena = offline->arena;
+
+    tree_cache_free(&offline->trees);
+    free(offline->ring);
+    sphincs_wipe(offline, sizeof(*offline));
+    if (arena) {
+        sphincs_arena_free(arena, offline);
+    } else {
+        free(offline);
+    }
+}
+
+int sphincs_offline_start(sphincs_offline **out, const sphincs_secret_key *sk, const sphincs_offline_config *config, sphincs_arena *arena) {
+    if (!out || !sk || !config) return OFFLINE_NULL_POINTER;
+
+    // Holds copies of the layer seeds, so it lives next to sk
+    sphincs_offline *offline = arena ? sphincs_arena_alloc(arena, sizeof(*offline)) : malloc(sizeof(*offline));
+    if (!offline) return OFFLINE_OUT_OF_MEMORY;
+    memset(offline, 0, sizeof(*offline));
+    offline->arena = arena;
+
+    offline->window = config->window > 0 ? config->window : 1;
+    offline->cpu_share = config->cpu_share < 1 ? 1 : config->cpu_share > 100 ? 100 : config->cpu_share;
+    offline->ring = malloc(offline->window * sizeof(*offline->ring));
+    if (!offline->ring) {
+        offline_free(offline);
+        return OFFLINE_OUT_OF_MEMORY;
+    }
+    int ret = hash_ctx_init(&offline->hash, sk->hash_id, sk->pub_seed);
+    if (ret == HASH_SUCCESS) {
+        // One bottom subtree and the top tree per layer, like the signer
+        ret = tree_cache_init(&offline->trees, SPHINCS_DEFAULT_CACHED_TREES, arena);
+    }
+    if (ret != 0) {
+        offline_free(offline);
+        return ret;
+    }
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        offline->layers[i] = sk->xmss_sk[i];
+        offline->next_idx[i] = sk->xmss_sk[i].idx;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&offline->wake, &attr);
+    pthread_cond_init(&offline->filled, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&offline->lock, NULL);
+
+    if (pthread_create(&offline->thread, NULL, offline_main, offline) != 0) {
+        pthread_mutex_destroy(&offline->lock);
+        pthread_cond_destroy(&offline->wake);
+        pthread_cond_destroy(&offline->filled);
+        offline_free(offline);
+        return OFFLINE_THREAD_ERROR;
+    }
+
+    *out = offline;
+    return OFFLINE_SUCCESS;
+}
+
+int sphincs_offline_take(sphincs_offline *offline, const sphincs_secret_key *sk, xmss_multitree_signature sigs[HYPER_LAYERS]) {
+    if (!offline || !sk || !sigs) return 0;
+
+    pthread_mutex_lock(&offline->lock);
+    // Layers advance in lock step, so anything behind layer 0 is stale
+    while (offline->count > 0 && offline->ring[offline->head].idx[0] < sk->xmss_sk[0].idx) {
+        offline->head = (offline->head + 1) % offline->window;
+        offline->count--;
+    }
+
+    int hit = offline->count > 0 && same_indices(offline->ring[offline->head].idx, sk);
+    if (hit) {
+        memcpy(sigs, offline->ring[offline->head].sigs, HYPER_LAYERS * sizeof(*sigs));
+        offline->head = (offline->head + 1) % offline->window;
+        offline->count--;
+    } else {
+        // The caller signs these indices inline; restart just past them
+        offline->head = 0;
+        offline->count = 0;
+        offline->stalled = 0;
+        for (int i = 0; i < HYPER_LAYERS; i++) {
+            offline->next_idx[i] = sk->xmss_sk[i].idx + 1;
+        }
+        offline->generation++;
+    }
+    pthread_cond_signal(&offline->wake);
+    pthread_mutex_unlock(&offline->lock);
+    return hit;
+}
+
+size_t sphincs_offline_wait_ready(sphincs_offline *offline, size_t count, unsigned timeout_ms) {
+    if (!offline) return 0;
+
+    uint64_t deadline = now_ns() + (uint64_t)timeout_ms * 1000000u;
+    struct timespec ts = { (time_t)(deadline / 1000000000u), (long)(deadline % 1000000000u) };
+    pthread_mutex_lock(&offline->lock);
+    if (count > offline->window) count = offline->window;
+    while (offline->count < count && !offline->stalled && !exhausted(offline->next_idx) && now_ns() < deadline) {
+        pthread_cond_timedwait(&offline->filled, &offline->lock, &ts);
+    }
+    size_t ready = offline->count;
+    pthread_mutex_unlock(&offline->lock);
+    return ready;
+}
+
+void sphincs_offline_stop(sphincs_offline *offline) {
+    if (!offline) return;
+
+    pthread_mutex_lock(&offline->lock);
+    offline->stopping = 1;
+    pthread_cond_signal(&offline->wake);
+    pthread_mutex_unlock(&offline->lock);
+    pthread_join(offline->thread, NULL);
+
+    pthread_cond_destroy(&offline->wake);
+    pthread_cond_destroy(&offline->filled);
+    pthread_mutex_destroy(&offline->lock);
+    offline_free(offline);
+}
+
+int sphincs_signer_start_offline(sphincs_signer *signer, const sphincs_offline_config *config) {
+    if (!signer || !config) return OFFLINE_NULL_POINTER;
+
+    sphincs_signer_stop_offline(signer);
+    return sphincs_offline_start(&signer->offline, signer->sk, config, signer->trees.arena);
+}
+
+void sphincs_signer_stop_offline(sphincs_signer *signer) {
+    if (!signer) return;
+
+    sphincs_offline_stop(signer->offline);
+    signer->offline = NULL;
+}
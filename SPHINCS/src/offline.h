@@ -0,0 +1,47 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sphincs.h"
+
+// Constants for error codes
+#define OFFLINE_SUCCESS 0
+#define OFFLINE_NULL_POINTER -1
+#define OFFLINE_OUT_OF_MEMORY -4
+#define OFFLINE_THREAD_ERROR -5
+
+typedef struct {
+    size_t window; // Upcoming signatures kept precomputed ahead of the key's index
+    int cpu_share; // Percent of one core the background thread may use, 1-100
+} sphincs_offline_config;
+
+// Start precomputing for sk from its current indices. Only the layer seeds
+// are copied; sk itself is never touched by the background thread. The
+// copies and the thread's tree cache come from arena (the heap when NULL).
+// If signing some indices fails the thread stops there until a take
+// misses, so the signer signs them inline and sees the error itself.
+int sphincs_offline_start(sphincs_offline **out, const sphincs_secret_key *sk, const sphincs_offline_config *config, sphincs_arena *arena);
+
+// If the hypertree signatures for sk's current indices are ready, copy
+// them to sigs and return 1. Otherwise return 0 and make the thread skip
+// past the index about to be signed inline.
+int sphincs_offline_take(sphincs_offline *offline, const sphincs_secret_key *sk, xmss_multitree_signature sigs[HYPER_LAYERS]);
+
+// Block until at least count entries (at most the window) are ready, the
+// thread has stalled or run out of indices, or timeout_ms has passed, and
+// return how many are ready. Mainly for tests and warm-up: take never
+// waits.
+size_t sphincs_offline_wait_ready(sphincs_offline *offline, size_t count, unsigned timeout_ms);
+
+// Stop the thread, then wipe and free the copied seeds and its trees
+void sphincs_offline_stop(sphincs_offline *offline);
+
+// Attach precomputation to a signer; sphincs_signer_sign and
+// sphincs_signer_sign_stream then only compute FORS online when the ring
+// has the next indices. Uses the signer's arena; sphincs_signer_free
+// stops it as well.
+int sphincs_signer_start_offline(sphincs_signer *signer, const sphincs_offline_config *config);
+void sphincs_signer_stop_offline(sphincs_signer *signer);
+
+#endif // OFFLINE_H
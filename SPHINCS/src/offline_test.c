@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+#include "offline.h"
+#include "arena.h"
+#include "test_util.h"
+
+static int make_key(sphincs_hash_ctx* ctx, sphincs_secret_key* sk) {
+    xmss_multitree_public_key pk;
+
+    memset(sk, 0, sizeof(*sk));
+    sk->hash_id = SPHINCS_HASH_SHA256;
+    memset(sk->pub_seed, 0x42, HASH_BYTES);
+    if (hash_ctx_init(ctx, sk->hash_id, sk->pub_seed) != HASH_SUCCESS) {
+        return 0;
+    }
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        uint8_t seed[HASH_BYTES] = { (uint8_t)(i + 1) };
+        if (xmss_keygen(ctx, &pk, &sk->xmss_sk[i], seed) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Generous enough for a starved SCHED_IDLE thread on a loaded machine
+#define TEST_FILL_TIMEOUT_MS 120000
+
+/* The layers sk would produce signing inline, without advancing it */
+static int sign_inline(const sphincs_hash_ctx* ctx, const sphincs_secret_key* sk, tree_cache* cache, xmss_multitree_signature* sigs) {
+    static const uint8_t msg[HASH_BYTES];
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        xmss_multitree_secret_key layer = sk->xmss_sk[i];
+        if (xmss_sign(ctx, &sigs[i], msg, &layer, cache) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void advance(sphincs_secret_key* sk) {
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        sk->xmss_sk[i].idx++;
+    }
+}
+
+/* Precomputed entries match inline signing; a take on indices that are
+   not ready misses, and the ring restarts just past them */
+static void test_take(const sphincs_hash_ctx* ctx, sphincs_secret_key* sk, sphincs_arena* arena) {
+    sphincs_offline_config config = { .window = 2, .cpu_share = 100 };
+    xmss_multitree_signature taken[HYPER_LAYERS], expected[2][HYPER_LAYERS];
+    sphincs_offline* offline;
+    tree_cache cache;
+    int ok = 1;
+
+    if (tree_cache_init(&cache, SPHINCS_DEFAULT_CACHED_TREES, NULL) != TREE_CACHE_SUCCESS) {
+        report("Offline take", 0);
+        return;
+    }
+    ok &= sign_inline(ctx, sk, &cache, expected[0]);
+    sphincs_secret_key next = *sk;
+    advance(&next);
+    ok &= sign_inline(ctx, &next, &cache, expected[1]);
+    sphincs_wipe(&next, sizeof(next));
+
+    if (!ok || sphincs_offline_start(&offline, sk, &config, arena) != OFFLINE_SUCCESS) {
+        tree_cache_free(&cache);
+        report("Offline take", 0);
+        return;
+    }
+    ok &= sphincs_offline_wait_ready(offline, config.window, TEST_FILL_TIMEOUT_MS) == config.window;
+    for (int n = 0; n < 2; ++n) {
+        ok &= sphincs_offline_take(offline, sk, taken) == 1;
+        ok &= memcmp(taken, expected[n], sizeof(taken)) == 0;
+        advance(sk);
+    }
+
+    // Skip past anything the window can hold: miss, then hit after it
+    for (size_t n = 0; n <= config.window; ++n) {
+        advance(sk);
+    }
+    ok &= sphincs_offline_take(offline, sk, taken) == 0;
+    advance(sk);
+    ok &= sign_inline(ctx, sk, &cache, expected[0]);
+    ok &= sphincs_offline_wait_ready(offline, 1, TEST_FILL_TIMEOUT_MS) >= 1;
+    ok &= sphincs_offline_take(offline, sk, taken) == 1;
+    ok &= memcmp(taken, expected[0], sizeof(taken)) == 0;
+    sphincs_offline_stop(offline);
+    tree_cache_free(&cache);
+    report("Offline take", ok);
+}
+
+/* Everything the offline state took from the arena is back on stop */
+static void test_arena(sphincs_secret_key* sk, sphincs_arena* arena) {
+    sphincs_offline_config config = { .window = 1, .cpu_share = 100 };
+    sphincs_offline* offline;
+    int ok = 1;
+
+    ok &= sphincs_offline_start(NULL, sk, &config, arena) == OFFLINE_NULL_POINTER;
+    ok &= sphincs_offline_start(&offline, sk, &config, arena) == OFFLINE_SUCCESS;
+    if (ok) {
+        uint8_t* p = (uint8_t*)offline;
+        ok &= p >= arena->base && p < arena->base + arena->size;
+        sphincs_offline_stop(offline);
+    }
+    void* all = sphincs_arena_alloc(arena, arena->size - ARENA_ALIGN);
+    ok &= all != NULL;
+    sphincs_arena_free(arena, all);
+    report("Offline arena", ok);
+}
+
+int main() {
+    static sphincs_secret_key sk;
+    sphincs_hash_ctx ctx;
+    sphincs_arena arena;
+
+    if (!make_key(&ctx, &sk) || sphincs_arena_init(&arena, 4u << 20) != ARENA_SUCCESS) {
+        report("Offline setup", 0);
+        return 1;
+    }
+    test_take(&ctx, &sk, &arena);
+    test_arena(&sk, &arena);
+    sphincs_arena_destroy(&arena);
+    return test_status();
+}
@@ -3,9 +3,20 @@
 #include "sha256.h"
 #include <string.h>
 
-/* RNG state */
-static uint8_t state[SHA256_DIGEST_SIZE];
-static uint64_t counter = 0;
+/* RNG state, per thread so concurrent keygen and signing never
+   interleave their streams */
+static _Thread_local uint8_t state[SHA256_DIGEST_SIZE];
+static _Thread_local uint64_t counter = 0;
+
+static void rng_prf(const uint8_t* in, size_t len, uint8_t* out) {
+    if (len == SHA256_DIGEST_SIZE + sizeof(uint64_t)) {
+        sha256_40(in, out); // state || counter
+    } else if (len == SHA256_DIGEST_SIZE) {
+        sha256_32(in, out);
+    } else {
+        sha256(in, len, out);
+    }
+}
 
 // Function to initialize the RNG state with a given seed
 void rng_init(const uint8_t* seed) {
@@ -25,7 +36,7 @@ void rng_generate(uint8_t* buffer, size_t size) {
         memcpy(input + SHA256_DIGEST_SIZE, &counter, sizeof(uint64_t));
 
         // Hash the input to produce random bytes
-        sha256(input, SHA256_DIGEST_SIZE + sizeof(uint64_t), buffer);
+        rng_prf(input, SHA256_DIGEST_SIZE + sizeof(uint64_t), buffer);
 
         // Update the buffer and size
         buffer += SHA256_DIGEST_SIZE;
@@ -35,5 +46,5 @@ void rng_generate(uint8_t* buffer, size_t size) {
 
 // Function to reseed the RNG state with a new seed
 void rng_reseed(const uint8_t* seed) {
-    sha256(seed, SHA256_DIGEST_SIZE, state);
+    rng_prf(seed, SHA256_DIGEST_SIZE, state);
 }
@@ -28,13 +28,56 @@ static const uint32_t k[64] = {
     0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-/* SHA-256 message schedule */
-static void sha256_prepare_schedule(const uint8_t* data, uint32_t* schedule) {
-    int i;
-    for (i = 0; i < 16; ++i) {
-        schedule[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) | (data[i * 4 + 2] << 8) | data[i * 4 + 3];
-    }
+/* Message schedules of the padding-only final block for inputs of exactly
+ * 64 and 128 bytes: 0x80, zeros, then the bit length. */
+static const uint32_t pad_schedule_512[64] = {
+    0x80000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000200,
+    0x80000000, 0x01400000, 0x00205000, 0x00005088,
+    0x22000800, 0x22550014, 0x05089742, 0xa0000020,
+    0x5a880000, 0x005c9400, 0x0016d49d, 0xfa801f00,
+    0xd33225d0, 0x11675959, 0xf6e6bfda, 0xb30c1549,
+    0x08b2b050, 0x9d7c4c27, 0x0ce2a393, 0x88e6e1ea,
+    0xa52b4335, 0x67a16f49, 0xd732016f, 0x4eeb2e91,
+    0x5dbf55e5, 0x8eee2335, 0xe2bc5ec2, 0xa83f4394,
+    0x45ad78f7, 0x36f3d0cd, 0xd99c05e8, 0xb0511dc7,
+    0x69bc7ac4, 0xbd11375b, 0xe3ba71e5, 0x3b209ff2,
+    0x18feee17, 0xe25ad9e7, 0x13375046, 0x0515089d,
+    0x4f0d0f04, 0x2627484e, 0x310128d2, 0xc668b434,
+    0x420841cc, 0x62d311b8, 0xe59ba771, 0x85a7a484
+};
+
+static const uint32_t pad_schedule_1024[64] = {
+    0x80000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000400,
+    0x80000000, 0x02800001, 0x00205000, 0x00000110,
+    0x22000800, 0x00aa0000, 0x05089942, 0xc0002ac0,
+    0x62080004, 0x1028c80a, 0x001a4055, 0x9f004823,
+    0x68ca269e, 0x323b15b4, 0x1886f73d, 0x5b6835a3,
+    0x37fd1798, 0x3311a7d2, 0xe8977a87, 0x55edccc1,
+    0x26785e65, 0x1c1a75cd, 0x1898add6, 0x70d975ed,
+    0xfc995de5, 0xc72d9f47, 0x225062f2, 0xfa62c148,
+    0x6d6275f8, 0x4876537f, 0x3e6bd0af, 0xaf3a394c,
+    0x5d69345c, 0x7d685338, 0x9ad3729d, 0xc04f60b4,
+    0x4af2ba27, 0x3b5ad539, 0x5b9a980b, 0x818b7cdd,
+    0x89cdea52, 0x2c88481e, 0x69cbcd7e, 0xd265fe42,
+    0xab09cb34, 0x9288f7b9, 0x9fb768b8, 0x9c18607f
+};
+
+/* Initial hash values (first 32 bits of the fractional parts of the square roots of the first 8 primes) */
+static const uint32_t iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define LOAD32_BE(p) (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
 
+/* Extend the first 16 schedule words to all 64 */
+static void sha256_expand_schedule(uint32_t* schedule) {
+    int i;
     for (i = 16; i < 64; ++i) {
         uint32_t s0 = ROTRIGHT(schedule[i - 15], 7) ^ ROTRIGHT(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
         uint32_t s1 = ROTRIGHT(schedule[i - 2], 17) ^ ROTRIGHT(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
@@ -42,12 +85,17 @@ static void sha256_prepare_schedule(const uint8_t* data, uint32_t* schedule) {
     }
 }
 
-/* SHA-256 transform function */
-static void sha256_transform(const uint8_t* data, uint32_t* state) {
-    /* SHA-256 message schedule */
-    uint32_t schedule[64];
-    sha256_prepare_schedule(data, schedule);
+/* SHA-256 message schedule */
+static void sha256_prepare_schedule(const uint8_t* data, uint32_t* schedule) {
+    int i;
+    for (i = 0; i < 16; ++i) {
+        schedule[i] = LOAD32_BE(data + i * 4);
+    }
+    sha256_expand_schedule(schedule);
+}
 
+/* SHA-256 compression function over a prepared message schedule */
+static void sha256_compress(uint32_t* state, const uint32_t* schedule) {
     /* Initialize working variables to current hash value */
     uint32_t a = state[0];
     uint32_t b = state[1];
@@ -89,39 +137,149 @@ static void sha256_transform(const uint8_t* data, uint32_t* state) {
     state[7] += h;
 }
 
-/* SHA-256 padding and pre-processing */
-static void sha256_padding(size_t len, uint8_t* padded_data) {
-    // Append a single 1-bit to the message
-    padded_data[len] = 0x80;
+/* SHA-256 transform function */
+static void sha256_transform(const uint8_t* data, uint32_t* state) {
+    /* SHA-256 message schedule */
+    uint32_t schedule[64];
+    sha256_prepare_schedule(data, schedule);
+    sha256_compress(state, schedule);
+}
 
-    /*Pad with zeros*/ 
-    for (size_t i = len + 1; i < 56; ++i) {
-        padded_data[i] = 0;
+static void sha256_store_state(const uint32_t* state, uint8_t* output) {
+    for (int i = 0; i < 8; ++i) {
+        output[i * 4 + 0] = (state[i] >> 24) & 0xFF;
+        output[i * 4 + 1] = (state[i] >> 16) & 0xFF;
+        output[i * 4 + 2] = (state[i] >> 8) & 0xFF;
+        output[i * 4 + 3] = state[i] & 0xFF;
     }
+}
 
-    /*Add message length in bits as 64-bit big-endian integer*/
-    uint64_t total_len = len * 8;
-    for (size_t i = 0; i < 8; ++i) {
-        padded_data[56 + i] = (total_len >> (56 - i * 8)) & 0xFF;
+/* Final block for a tail of len bytes (a multiple of 4, at most 52) ending a
+ * message of total_len bytes. The words are loaded straight from the input;
+ * the padding and length words are constants. */
+static void sha256_final_short(uint32_t* state, const uint8_t* data, size_t len, uint64_t total_len, uint8_t* output) {
+    uint32_t schedule[64];
+    size_t words = len / 4;
+    size_t i;
+
+    for (i = 0; i < words; ++i) {
+        schedule[i] = LOAD32_BE(data + i * 4);
+    }
+    schedule[words] = 0x80000000;
+    for (i = words + 1; i < 14; ++i) {
+        schedule[i] = 0;
     }
+    schedule[14] = (uint32_t)((total_len * 8) >> 32);
+    schedule[15] = (uint32_t)(total_len * 8);
+    sha256_expand_schedule(schedule);
+    sha256_compress(state, schedule);
+    sha256_store_state(state, output);
 }
 
-void sha256(const uint8_t* data, size_t len, uint8_t* output) {
-    /* Initial hash values (first 32 bits of the fractional parts of the square roots of the first 8 primes) */
-    uint32_t state[8] = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
+void sha256_32(const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, iv, sizeof(iv));
+    sha256_final_short(state, data, 32, 32, output);
+}
 
-    uint8_t padded_data[64]; /* 512-bit blocks for SHA-256 */
-    memcpy(padded_data, data, len);
-    sha256_padding(len, padded_data);
-    sha256_transform(padded_data, state);
+void sha256_40(const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, iv, sizeof(iv));
+    sha256_final_short(state, data, 40, 40, output);
+}
 
-    /* Convert the final state to little-endian bytes and copy it to the output buffer*/
-    for (int i = 0; i < 8; ++i) {
-        output[i * 4 + 0] = (state[i] >> 24) & 0xFF;
-        output[i * 4 + 1] = (state[i] >> 16) & 0xFF;
-        output[i * 4 + 2] = (state[i] >> 8) & 0xFF;
-        output[i * 4 + 3] = state[i] & 0xFF;
+void sha256_64(const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, iv, sizeof(iv));
+    sha256_transform(data, state);
+    sha256_compress(state, pad_schedule_512);
+    sha256_store_state(state, output);
+}
+
+void sha256_96(const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, iv, sizeof(iv));
+    sha256_transform(data, state);
+    sha256_final_short(state, data + SHA256_BLOCK_SIZE, 32, 96, output);
+}
+
+void sha256_midstate_32(const sha256_ctx* midstate, const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, midstate->state, sizeof(state));
+    sha256_final_short(state, data, 32, SHA256_BLOCK_SIZE + 32, output);
+}
+
+void sha256_midstate_64(const sha256_ctx* midstate, const uint8_t* data, uint8_t* output) {
+    uint32_t state[8];
+    memcpy(state, midstate->state, sizeof(state));
+    sha256_transform(data, state);
+    sha256_compress(state, pad_schedule_1024);
+    sha256_store_state(state, output);
+}
+
+void sha256_init(sha256_ctx* ctx) {
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+    ctx->buffered = 0;
+}
+
+void sha256_update(sha256_ctx* ctx, const uint8_t* data, size_t len) {
+    /* Top up a partially filled block first */
+    if (ctx->buffered > 0) {
+        size_t take = SHA256_BLOCK_SIZE - ctx->buffered;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buffer + ctx->buffered, data, take);
+        ctx->buffered += take;
+        data += take;
+        len -= take;
+        if (ctx->buffered < SHA256_BLOCK_SIZE) {
+            return;
+        }
+        sha256_transform(ctx->buffer, ctx->state);
+        ctx->count += SHA256_BLOCK_SIZE;
+        ctx->buffered = 0;
     }
+
+    /* Compress whole blocks straight from the input */
+    while (len >= SHA256_BLOCK_SIZE) {
+        sha256_transform(data, ctx->state);
+        ctx->count += SHA256_BLOCK_SIZE;
+        data += SHA256_BLOCK_SIZE;
+        len -= SHA256_BLOCK_SIZE;
+    }
+
+    memcpy(ctx->buffer, data, len);
+    ctx->buffered = len;
+}
+
+void sha256_final(sha256_ctx* ctx, uint8_t* output) {
+    uint64_t total_len = (ctx->count + ctx->buffered) * 8;
+    size_t i = ctx->buffered;
+
+    /* Append a single 1-bit to the message, then pad with zeros */
+    ctx->buffer[i++] = 0x80;
+    if (i > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + i, 0, SHA256_BLOCK_SIZE - i);
+        sha256_transform(ctx->buffer, ctx->state);
+        i = 0;
+    }
+    memset(ctx->buffer + i, 0, SHA256_BLOCK_SIZE - 8 - i);
+
+    /* Add message length in bits as 64-bit big-endian integer */
+    for (i = 0; i < 8; ++i) {
+        ctx->buffer[56 + i] = (total_len >> (56 - i * 8)) & 0xFF;
+    }
+    sha256_transform(ctx->buffer, ctx->state);
+
+    /* Convert the final state to big-endian bytes and copy it to the output buffer */
+    sha256_store_state(ctx->state, output);
+}
+
+void sha256(const uint8_t* data, size_t len, uint8_t* output) {
+    sha256_ctx ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, output);
 }
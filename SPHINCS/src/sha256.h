@@ -7,6 +7,32 @@
 #define SHA256_BLOCK_SIZE  64
 #define SHA256_DIGEST_SIZE 32
 
+/* Incremental SHA-256 state. Copying a context after absorbing a prefix
+ * gives a reusable midstate for hashes that share that prefix. */
+typedef struct {
+    uint32_t state[8];
+    uint64_t count;                     /* bytes already compressed */
+    uint8_t buffer[SHA256_BLOCK_SIZE];
+    size_t buffered;                    /* bytes waiting in buffer */
+} sha256_ctx;
+
+void sha256_init(sha256_ctx* ctx);
+void sha256_update(sha256_ctx* ctx, const uint8_t* data, size_t len);
+void sha256_final(sha256_ctx* ctx, uint8_t* output);
+
 void sha256(const uint8_t* data, size_t len, uint8_t* output);
 
+/* Fixed-length kernels for the sizes the scheme hashes most. Input words go
+ * straight into the message schedule and the padding is constant, so
+ * nothing is copied or padded at run time. */
+void sha256_32(const uint8_t* data, uint8_t* output);
+void sha256_40(const uint8_t* data, uint8_t* output);
+void sha256_64(const uint8_t* data, uint8_t* output);
+void sha256_96(const uint8_t* data, uint8_t* output);
+
+/* Same, continuing from a midstate that has absorbed exactly one block
+ * (total message lengths of 96 and 128 bytes). */
+void sha256_midstate_32(const sha256_ctx* midstate, const uint8_t* data, uint8_t* output);
+void sha256_midstate_64(const sha256_ctx* midstate, const uint8_t* data, uint8_t* output);
+
 #endif // SHA256_H
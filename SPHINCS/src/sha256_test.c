@@ -1,16 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "sha256.h"
-
-/* Function to compare two arrays of bytes */
-int compare_bytes(const uint8_t* arr1, const uint8_t* arr2, size_t len) {
-    for (size_t i = 0; i < len; ++i) {
-        if (arr1[i] != arr2[i]) {
-            return 0;
-        }
-    }
-    return 1;
-}
+#include "test_util.h"
 
 /* Function to execute the SHA-256 hash on a certain message input */
 void test_sha256() {
@@ -44,16 +35,54 @@ struct TestVector test_vectors[] = {
     /* Run the tests and compare results */
     for (size_t i = 0; i < num_test_vectors; ++i) {
         sha256((const uint8_t*)test_vectors[i].input, strlen(test_vectors[i].input), output);
-        if (compare_bytes(output, test_vectors[i].output, SHA256_DIGEST_SIZE)) {
-            printf("Test %d passed!\n", i + 1);
-        } else {
-            printf("Test %d failed!\n", i + 1);
-        }
+        char name[32];
+        snprintf(name, sizeof(name), "Test %zu", i + 1);
+        report(name, compare_bytes(output, test_vectors[i].output, SHA256_DIGEST_SIZE));
+    }
+}
+
+/* Function to check the fixed-length kernels against the generic path */
+void test_sha256_fixed() {
+    uint8_t data[3 * SHA256_BLOCK_SIZE];
+    uint8_t expected[SHA256_DIGEST_SIZE];
+    uint8_t output[SHA256_DIGEST_SIZE];
+    sha256_ctx midstate;
+
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(i * 7 + 3);
     }
+
+    sha256(data, 32, expected);
+    sha256_32(data, output);
+    report("Fixed 32", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
+
+    sha256(data, 40, expected);
+    sha256_40(data, output);
+    report("Fixed 40", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
+
+    sha256(data, 64, expected);
+    sha256_64(data, output);
+    report("Fixed 64", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
+
+    sha256(data, 96, expected);
+    sha256_96(data, output);
+    report("Fixed 96", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
+
+    sha256_init(&midstate);
+    sha256_update(&midstate, data, SHA256_BLOCK_SIZE);
+
+    sha256(data, SHA256_BLOCK_SIZE + 32, expected);
+    sha256_midstate_32(&midstate, data + SHA256_BLOCK_SIZE, output);
+    report("Midstate 32", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
+
+    sha256(data, SHA256_BLOCK_SIZE + 64, expected);
+    sha256_midstate_64(&midstate, data + SHA256_BLOCK_SIZE, output);
+    report("Midstate 64", compare_bytes(output, expected, SHA256_DIGEST_SIZE));
 }
 
 int main() {
     /* Call the function to test SHA-256 implementation */
     test_sha256();
-    return 0;
+    test_sha256_fixed();
+    return test_status();
 }
\ No newline at end of file
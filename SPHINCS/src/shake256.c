@@ -0,0 +1,114 @@
+#include "shake256.h"
+#include <string.h>
+
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static const uint64_t keccak_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+static const unsigned keccak_rho[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+    27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static const unsigned keccak_pi[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+    15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+};
+
+/* Keccak-f[1600] permutation */
+static void keccak_f1600(uint64_t* s) {
+    uint64_t bc[5];
+    uint64_t t;
+    int round, i, j;
+
+    for (round = 0; round < 24; ++round) {
+        /* Theta */
+        for (i = 0; i < 5; ++i) {
+            bc[i] = s[i] ^ s[i + 5] ^ s[i + 10] ^ s[i + 15] ^ s[i + 20];
+        }
+        for (i = 0; i < 5; ++i) {
+            t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
+            for (j = 0; j < 25; j += 5) {
+                s[j + i] ^= t;
+            }
+        }
+
+        /* Rho and Pi */
+        t = s[1];
+        for (i = 0; i < 24; ++i) {
+            j = keccak_pi[i];
+            bc[0] = s[j];
+            s[j] = ROTL64(t, keccak_rho[i]);
+            t = bc[0];
+        }
+
+        /* Chi */
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; ++i) {
+                bc[i] = s[j + i];
+            }
+            for (i = 0; i < 5; ++i) {
+                s[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+            }
+        }
+
+        /* Iota */
+        s[0] ^= keccak_rc[round];
+    }
+}
+
+/* Lanes are little-endian regardless of host byte order */
+static void keccak_xor_byte(uint64_t* s, size_t pos, uint8_t byte) {
+    s[pos / 8] ^= (uint64_t)byte << (8 * (pos % 8));
+}
+
+void shake256_init(shake256_ctx* ctx) {
+    memset(ctx->s, 0, sizeof(ctx->s));
+    ctx->pos = 0;
+}
+
+void shake256_absorb(shake256_ctx* ctx, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        keccak_xor_byte(ctx->s, ctx->pos, *data++);
+        --len;
+        if (++ctx->pos == SHAKE256_RATE) {
+            keccak_f1600(ctx->s);
+            ctx->pos = 0;
+        }
+    }
+}
+
+void shake256_finalize(shake256_ctx* ctx) {
+    /* SHAKE domain separation (1111) followed by pad10*1 */
+    keccak_xor_byte(ctx->s, ctx->pos, 0x1F);
+    keccak_xor_byte(ctx->s, SHAKE256_RATE - 1, 0x80);
+    keccak_f1600(ctx->s);
+    ctx->pos = 0;
+}
+
+void shake256_squeeze(shake256_ctx* ctx, uint8_t* output, size_t outlen) {
+    while (outlen > 0) {
+        if (ctx->pos == SHAKE256_RATE) {
+            keccak_f1600(ctx->s);
+            ctx->pos = 0;
+        }
+        *output++ = (uint8_t)(ctx->s[ctx->pos / 8] >> (8 * (ctx->pos % 8)));
+        ++ctx->pos;
+        --outlen;
+    }
+}
+
+void shake256(const uint8_t* data, size_t len, uint8_t* output, size_t outlen) {
+    shake256_ctx ctx;
+    shake256_init(&ctx);
+    shake256_absorb(&ctx, data, len);
+    shake256_finalize(&ctx);
+    shake256_squeeze(&ctx, output, outlen);
+}
@@ -0,0 +1,23 @@
+#ifndef SHAKE256_H
+#define SHAKE256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHAKE256_RATE 136
+
+/* Incremental SHAKE256 (FIPS 202) state. Absorb with shake256_absorb,
+ * call shake256_finalize once, then squeeze any number of bytes. */
+typedef struct {
+    uint64_t s[25];
+    size_t pos;
+} shake256_ctx;
+
+void shake256_init(shake256_ctx* ctx);
+void shake256_absorb(shake256_ctx* ctx, const uint8_t* data, size_t len);
+void shake256_finalize(shake256_ctx* ctx);
+void shake256_squeeze(shake256_ctx* ctx, uint8_t* output, size_t outlen);
+
+void shake256(const uint8_t* data, size_t len, uint8_t* output, size_t outlen);
+
+#endif // SHAKE256_H
@@ -0,0 +1,245 @@
+#include "sign_service.h"
+#include "snapshot.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t *msg;
+    size_t len;
+    sphincs_sign_callback callback;
+    void *user;
+    int status;
+    uint8_t digest[HASH_BYTES];
+    sphincs_signature sig;
+} sign_request;
+
+struct sphincs_sign_service {
+    sphincs_signer signer;
+    size_t max_batch;
+
+    // Bounded ring of pending requests
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t idle;
+    sign_request **queue;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    size_t in_flight;
+    int stopping;
+
+    // Serialises the hypertree half of signing (key indices, tree cache)
+    pthread_mutex_t key_lock;
+
+    pthread_t *threads;
+    int workers;
+};
+
+static void free_request(sign_request *req) {
+    free(req->msg);
+    free(req);
+}
+
+// The message digests and FORS signatures only read the key, so workers
+// compute them concurrently; the key lock covers just the hypertree half,
+// taken once per batch. Callbacks run afterwards so a slow consumer never
+// holds up the next batch.
+static void sign_batch(sphincs_sign_service *svc, sign_request **batch, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        batch[i]->status = sphincs_signer_sign_fors(&svc->signer, &batch[i]->sig, batch[i]->digest, batch[i]->msg, batch[i]->len);
+    }
+
+    pthread_mutex_lock(&svc->key_lock);
+    for (size_t i = 0; i < n; i++) {
+        if (batch[i]->status == 0) {
+            batch[i]->status = sphincs_signer_sign_layers(&svc->signer, &batch[i]->sig, batch[i]->digest);
+        }
+    }
+    pthread_mutex_unlock(&svc->key_lock);
+
+    for (size_t i = 0; i < n; i++) {
+        batch[i]->callback(batch[i]->status, &batch[i]->sig, batch[i]->user);
+        free_request(batch[i]);
+    }
+}
+
+static void *worker_main(void *arg) {
+    sphincs_sign_service *svc = arg;
+    sign_request **batch = malloc(svc->max_batch * sizeof(*batch));
+
+    for (;;) {
+        pthread_mutex_lock(&svc->lock);
+        while (svc->count == 0 && !svc->stopping) {
+            pthread_cond_wait(&svc->not_empty, &svc->lock);
+        }
+        if (svc->count == 0) {
+            pthread_mutex_unlock(&svc->lock);
+            break;
+        }
+
+        // Coalesce whatever has accumulated, up to the batch limit
+        size_t n = batch ? svc->max_batch : 1;
+        sign_request *single;
+        sign_request **dst = batch ? batch : &single;
+        if (n > svc->count) {
+            n = svc->count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = svc->queue[svc->head];
+            svc->head = (svc->head + 1) % svc->capacity;
+        }
+        svc->count -= n;
+        svc->in_flight += n;
+        pthread_mutex_unlock(&svc->lock);
+
+        sign_batch(svc, dst, n);
+
+        pthread_mutex_lock(&svc->lock);
+        svc->in_flight -= n;
+        if (svc->count == 0 && svc->in_flight == 0) {
+            pthread_cond_broadcast(&svc->idle);
+        }
+        pthread_mutex_unlock(&svc->lock);
+    }
+
+    free(batch);
+    return NULL;
+}
+
+int sphincs_sign_service_create(sphincs_sign_service **out, sphincs_secret_key *sk, const sphincs_sign_service_config *config) {
+    if (!out || !sk || !config) return SIGN_SERVICE_NULL_POINTER;
+
+    sphincs_sign_service *svc = calloc(1, sizeof(*svc));
+    if (!svc) return SIGN_SERVICE_OUT_OF_MEMORY;
+
+    svc->capacity = config->queue_capacity > 0 ? config->queue_capacity : 1;
+    svc->max_batch = config->max_batch > 0 ? config->max_batch : 1;
+    svc->queue = malloc(svc->capacity * sizeof(*svc->queue));
+    svc->threads = malloc((config->workers > 0 ? config->workers : 1) * sizeof(*svc->threads));
+    if (!svc->queue || !svc->threads) {
+        free(svc->queue);
+        free(svc->threads);
+        free(svc);
+        return SIGN_SERVICE_OUT_OF_MEMORY;
+    }
+    int ret = sphincs_signer_init(&svc->signer, sk, SPHINCS_DEFAULT_CACHED_TREES, config->arena);
+    if (ret == 0 && config->offline) {
+        ret = sphincs_signer_start_offline(&svc->signer, config->offline);
+        if (ret != 0) {
+            sphincs_signer_free(&svc->signer);
+        }
+    }
+    if (ret != 0) {
+        free(svc->queue);
+        free(svc->threads);
+        free(svc);
+        return SIGN_SERVICE_INIT_FAILED;
+    }
+
+    pthread_mutex_init(&svc->lock, NULL);
+    pthread_mutex_init(&svc->key_lock, NULL);
+    pthread_cond_init(&svc->not_empty, NULL);
+    pthread_cond_init(&svc->idle, NULL);
+
+    int workers = config->workers > 0 ? config->workers : 1;
+    for (svc->workers = 0; svc->workers < workers; svc->workers++) {
+        if (pthread_create(&svc->threads[svc->workers], NULL, worker_main, svc) != 0) {
+            sphincs_sign_service_destroy(svc);
+            return SIGN_SERVICE_THREAD_ERROR;
+        }
+    }
+
+    *out = svc;
+    return SIGN_SERVICE_SUCCESS;
+}
+
+int sphincs_sign_submit(sphincs_sign_service *svc, const uint8_t *msg, size_t len, sphincs_sign_callback callback, void *user) {
+    if (!svc || (!msg && len > 0) || !callback) return SIGN_SERVICE_NULL_POINTER;
+
+    sign_request *req = malloc(sizeof(*req));
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    if (!req || !copy) {
+        free(req);
+        free(copy);
+        return SIGN_SERVICE_OUT_OF_MEMORY;
+    }
+    if (len > 0) {
+        memcpy(copy, msg, len);
+    }
+    req->msg = copy;
+    req->len = len;
+    req->callback = callback;
+    req->user = user;
+
+    pthread_mutex_lock(&svc->lock);
+    int ret = SIGN_SERVICE_SUCCESS;
+    if (svc->stopping) {
+        ret = SIGN_SERVICE_SHUTTING_DOWN;
+    } else if (svc->count == svc->capacity) {
+        ret = SIGN_SERVICE_QUEUE_FULL;
+    } else {
+        svc->queue[(svc->head + svc->count) % svc->capacity] = req;
+        svc->count++;
+        pthread_cond_signal(&svc->not_empty);
+    }
+    pthread_mutex_unlock(&svc->lock);
+
+    if (ret != SIGN_SERVICE_SUCCESS) {
+        free_request(req);
+    }
+    return ret;
+}
+
+size_t sphincs_sign_service_pending(sphincs_sign_service *svc) {
+    if (!svc) return 0;
+
+    pthread_mutex_lock(&svc->lock);
+    size_t pending = svc->count + svc->in_flight;
+    pthread_mutex_unlock(&svc->lock);
+    return pending;
+}
+
+int sphincs_sign_service_save_snapshot(sphincs_sign_service *svc, const sphincs_public_key *pk, const char *path) {
+    if (!svc) return SNAPSHOT_NULL_POINTER;
+
+    // Holding the key lock keeps the indices and cached trees still while
+    // they are written; FORS signing carries on meanwhile
+    pthread_mutex_lock(&svc->key_lock);
+    int ret = sphincs_signer_save_snapshot(&svc->signer, pk, path);
+    pthread_mutex_unlock(&svc->key_lock);
+    return ret;
+}
+
+void sphincs_sign_service_drain(sphincs_sign_service *svc) {
+    if (!svc) return;
+
+    pthread_mutex_lock(&svc->lock);
+    while (svc->count > 0 || svc->in_flight > 0) {
+        pthread_cond_wait(&svc->idle, &svc->lock);
+    }
+    pthread_mutex_unlock(&svc->lock);
+}
+
+void sphincs_sign_service_destroy(sphincs_sign_service *svc) {
+    if (!svc) return;
+
+    pthread_mutex_lock(&svc->lock);
+    svc->stopping = 1;
+    pthread_cond_broadcast(&svc->not_empty);
+    pthread_mutex_unlock(&svc->lock);
+
+    // Workers only exit once the queue is empty, so nothing is dropped
+    for (int i = 0; i < svc->workers; i++) {
+        pthread_join(svc->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&svc->idle);
+    pthread_cond_destroy(&svc->not_empty);
+    pthread_mutex_destroy(&svc->key_lock);
+    pthread_mutex_destroy(&svc->lock);
+    sphincs_signer_free(&svc->signer);
+    free(svc->threads);
+    free(svc->queue);
+    free(svc);
+}
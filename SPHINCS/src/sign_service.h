@@ -0,0 +1,68 @@
+#ifndef SIGN_SERVICE_H
+#define SIGN_SERVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sphincs.h"
+#include "offline.h"
+
+// Constants for error codes
+#define SIGN_SERVICE_SUCCESS 0
+#define SIGN_SERVICE_NULL_POINTER -1
+#define SIGN_SERVICE_QUEUE_FULL -2
+#define SIGN_SERVICE_SHUTTING_DOWN -3
+#define SIGN_SERVICE_OUT_OF_MEMORY -4
+#define SIGN_SERVICE_THREAD_ERROR -5
+#define SIGN_SERVICE_INIT_FAILED -6 // The signer or its offline state could not be set up
+
+// Called from a worker thread once a request completes. status is the
+// sphincs_signer_sign result; sig is only valid for the duration of the call.
+// The callback runs on a worker, so it must not call
+// sphincs_sign_service_drain or sphincs_sign_service_destroy: both wait
+// for that worker and would deadlock. Submitting from it is fine.
+typedef void (*sphincs_sign_callback)(int status, const sphincs_signature *sig, void *user);
+
+typedef struct {
+    size_t queue_capacity; // Pending requests accepted before submit reports SIGN_SERVICE_QUEUE_FULL
+    int workers;           // Worker threads draining the queue
+    size_t max_batch;      // Requests a worker takes per wakeup (see below)
+    sphincs_arena *arena;  // Backs the signer's tree cache; may be NULL
+    const sphincs_offline_config *offline; // Precompute upcoming signatures between bursts; may be NULL
+} sphincs_sign_service_config;
+
+typedef struct sphincs_sign_service sphincs_sign_service;
+
+// Batching amortises wakeups, the key lock and hash set-up over up to
+// max_batch requests. Message digests and FORS signatures run on all
+// workers at once; the hypertree half of each signature advances the
+// key's indices and is serialised per key. Requests in a batch are
+// still signed one after another: their hash rounds are not merged into
+// multi-lane calls.
+
+// The service owns sk until it is destroyed: the key index is shared
+// state, so no other thread may sign with sk in the meantime. Returns
+// SIGN_SERVICE_SUCCESS or one of the SIGN_SERVICE_* errors above.
+int sphincs_sign_service_create(sphincs_sign_service **out, sphincs_secret_key *sk, const sphincs_sign_service_config *config);
+
+// Queue msg (copied) for signing. Never blocks; returns
+// SIGN_SERVICE_QUEUE_FULL when the queue is at capacity so callers can shed
+// load or retry.
+int sphincs_sign_submit(sphincs_sign_service *svc, const uint8_t *msg, size_t len, sphincs_sign_callback callback, void *user);
+
+// Requests queued or being signed right now
+size_t sphincs_sign_service_pending(sphincs_sign_service *svc);
+
+// Write the service's tree cache and key indices to a snapshot at path
+// (see snapshot.h) while requests keep flowing. Hypertree signing waits
+// for the write to finish. Returns a SNAPSHOT_* code.
+int sphincs_sign_service_save_snapshot(sphincs_sign_service *svc, const sphincs_public_key *pk, const char *path);
+
+// Block until every request submitted so far has had its callback run.
+// Never call from a callback.
+void sphincs_sign_service_drain(sphincs_sign_service *svc);
+
+// Stop accepting requests, finish the queued ones, join the workers and
+// free svc. Never call from a callback.
+void sphincs_sign_service_destroy(sphincs_sign_service *svc);
+
+#endif // SIGN_SERVICE_H
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "sign_service.h"
+#include "test_util.h"
+
+#define TEST_REQUESTS 16
+
+typedef struct {
+    pthread_mutex_t lock;
+    int calls;
+    int failures;
+    uint32_t leaf_idx[TEST_REQUESTS];
+    sphincs_signature sigs[TEST_REQUESTS];
+} results;
+
+typedef struct {
+    results *results;
+    int slot;
+} request;
+
+static void on_signed(int status, const sphincs_signature* sig, void* user) {
+    request* req = user;
+    results* r = req->results;
+
+    pthread_mutex_lock(&r->lock);
+    r->calls++;
+    if (status != 0) {
+        r->failures++;
+    } else {
+        r->sigs[req->slot] = *sig;
+        r->leaf_idx[req->slot] = sig->xmss_sig[0].leaf_idx;
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+/* Submit more requests than the queue holds, drain, and check that every
+   callback ran once with a valid signature on its own leaf */
+static void test_submit_drain(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    sphincs_sign_service_config config = { .queue_capacity = 4, .workers = 3, .max_batch = 2 };
+    sphincs_sign_service* svc;
+    static results r;
+    request reqs[TEST_REQUESTS];
+    uint8_t msgs[TEST_REQUESTS][8];
+    int ok = 1;
+
+    memset(&r, 0, sizeof(r));
+    pthread_mutex_init(&r.lock, NULL);
+    if (sphincs_sign_service_create(&svc, sk, &config) != SIGN_SERVICE_SUCCESS) {
+        report("Sign service submit/drain", 0);
+        return;
+    }
+    for (int i = 0; i < TEST_REQUESTS; ++i) {
+        reqs[i].results = &r;
+        reqs[i].slot = i;
+        memset(msgs[i], 'a' + i, sizeof(msgs[i]));
+        int ret;
+        while ((ret = sphincs_sign_submit(svc, msgs[i], sizeof(msgs[i]), on_signed, &reqs[i])) == SIGN_SERVICE_QUEUE_FULL) {
+            sphincs_sign_service_drain(svc);
+        }
+        ok &= ret == SIGN_SERVICE_SUCCESS;
+    }
+    sphincs_sign_service_drain(svc);
+    ok &= sphincs_sign_service_pending(svc) == 0;
+    sphincs_sign_service_destroy(svc);
+
+    ok &= r.calls == TEST_REQUESTS && r.failures == 0;
+    sphincs_prepared_pk prepared;
+    ok &= sphincs_prepare_pk(&prepared, pk) == 0;
+    for (int i = 0; i < TEST_REQUESTS && ok; ++i) {
+        ok &= sphincs_verify_prepared(&r.sigs[i], msgs[i], sizeof(msgs[i]), &prepared) == 1;
+        for (int j = 0; j < i; ++j) {
+            ok &= r.leaf_idx[i] != r.leaf_idx[j];
+        }
+    }
+    ok &= sk->xmss_sk[0].idx == TEST_REQUESTS;
+    pthread_mutex_destroy(&r.lock);
+    report("Sign service submit/drain", ok);
+}
+
+static void test_null_arguments(sphincs_secret_key* sk) {
+    sphincs_sign_service_config config = { .queue_capacity = 1, .workers = 1, .max_batch = 1 };
+    sphincs_sign_service* svc;
+    sphincs_secret_key bad_hash = *sk;
+    int ok = 1;
+
+    // A signer set-up failure gets its own code, not the signer's
+    bad_hash.hash_id = (sphincs_hash_id)99;
+    ok &= sphincs_sign_service_create(&svc, &bad_hash, &config) == SIGN_SERVICE_INIT_FAILED;
+    sphincs_wipe(&bad_hash, sizeof(bad_hash));
+
+    ok &= sphincs_sign_service_create(NULL, sk, &config) == SIGN_SERVICE_NULL_POINTER;
+    ok &= sphincs_sign_service_create(&svc, sk, NULL) == SIGN_SERVICE_NULL_POINTER;
+    if (sphincs_sign_service_create(&svc, sk, &config) == SIGN_SERVICE_SUCCESS) {
+        ok &= sphincs_sign_submit(svc, (const uint8_t*)"m", 1, NULL, NULL) == SIGN_SERVICE_NULL_POINTER;
+        ok &= sphincs_sign_submit(svc, NULL, 1, on_signed, NULL) == SIGN_SERVICE_NULL_POINTER;
+        sphincs_sign_service_destroy(svc);
+    } else {
+        ok = 0;
+    }
+    report("Sign service arguments", ok);
+}
+
+int main() {
+    static sphincs_public_key pk;
+    static sphincs_secret_key sk;
+    uint8_t seed[HASH_BYTES] = { 0x5A };
+
+    if (sphincs_keygen(&pk, &sk, seed) != 0) {
+        report("Sign service keygen", 0);
+        return 1;
+    }
+    test_null_arguments(&sk);
+    test_submit_drain(&sk, &pk);
+    return test_status();
+}
@@ -0,0 +1,320 @@
+#include "snapshot.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout, in the writer's native byte order: header, entry table,
+// then each tree's nodes in merkle_tree order at a MERKLE_ALIGN offset.
+#define SNAPSHOT_MAGIC "SPXTREE"
+#define SNAPSHOT_MAC_LABEL "SPXTREE snapshot MAC"
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t hash_id;
+    uint32_t entry_count;
+    uint32_t idx[HYPER_LAYERS]; // Leaf indices at the time of the snapshot
+    uint32_t reserved;
+    uint64_t file_size;
+    uint8_t pub_seed[HASH_BYTES];
+    uint8_t pk_root[HASH_BYTES];
+    uint8_t mac[HASH_BYTES]; // HMAC-SHA256 of the file with this field zeroed
+} snapshot_header;
+
+typedef struct {
+    uint32_t layer;
+    uint32_t tree_id;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t offset;
+} snapshot_entry;
+
+static size_t align_up(size_t n) {
+    return (n + MERKLE_ALIGN - 1) & ~(size_t)(MERKLE_ALIGN - 1);
+}
+
+static size_t tree_bytes(int height) {
+    return (size_t)MERKLE_NODES(height) * HASH_BYTES;
+}
+
+// The MAC key hashes every layer's secret seed, so it is as secret as sk
+static void derive_mac_key(const sphincs_secret_key *sk, uint8_t *key) {
+    sha256_ctx sha;
+
+    sha256_init(&sha);
+    sha256_update(&sha, (const uint8_t *)SNAPSHOT_MAC_LABEL, sizeof(SNAPSHOT_MAC_LABEL));
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        sha256_update(&sha, sk->xmss_sk[i].sk, HASH_BYTES);
+    }
+    sha256_final(&sha, key);
+    sphincs_wipe(&sha, sizeof(sha));
+}
+
+// HMAC-SHA256 (RFC 2104) over the file with the header's mac field zeroed
+static void compute_mac(const sphincs_secret_key *sk, const uint8_t *file, size_t size, uint8_t *out) {
+    uint8_t key[HASH_BYTES], pad[SHA256_BLOCK_SIZE], inner[HASH_BYTES];
+    snapshot_header header;
+    sha256_ctx sha;
+
+    derive_mac_key(sk, key);
+    memcpy(&header, file, sizeof(header));
+    memset(header.mac, 0, sizeof(header.mac));
+
+    memset(pad, 0x36, sizeof(pad));
+    for (int i = 0; i < HASH_BYTES; i++) pad[i] ^= key[i];
+    sha256_init(&sha);
+    sha256_update(&sha, pad, sizeof(pad));
+    sha256_update(&sha, (const uint8_t *)&header, sizeof(header));
+    sha256_update(&sha, file + sizeof(header), size - sizeof(header));
+    sha256_final(&sha, inner);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (int i = 0; i < HASH_BYTES; i++) pad[i] ^= key[i];
+    sha256_init(&sha);
+    sha256_update(&sha, pad, sizeof(pad));
+    sha256_update(&sha, inner, sizeof(inner));
+    sha256_final(&sha, out);
+
+    sphincs_wipe(key, sizeof(key));
+    sphincs_wipe(pad, sizeof(pad));
+    sphincs_wipe(&sha, sizeof(sha));
+}
+
+static int same_mac(const uint8_t *a, const uint8_t *b) {
+    uint8_t diff = 0;
+    for (int i = 0; i < HASH_BYTES; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+// Hypertree layer whose seed owns a cached tree, or -1 for another key
+static int owner_layer(const sphincs_secret_key *sk, const uint8_t *owner) {
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (memcmp(sk->xmss_sk[i].sk, owner, HASH_BYTES) == 0) return i;
+    }
+    return -1;
+}
+
+int sphincs_signer_save_snapshot(const sphincs_signer *signer, const sphincs_public_key *pk, const char *path) {
+    if (!signer || !pk || !path) return SNAPSHOT_NULL_POINTER;
+
+    const tree_cache *cache = &signer->trees;
+    const sphincs_secret_key *sk = signer->sk;
+    size_t count = 0, size;
+
+    for (size_t i = 0; i < cache->capacity; i++) {
+        count += cache->entries[i].valid && owner_layer(sk, cache->entries[i].owner) >= 0;
+    }
+    size = align_up(sizeof(snapshot_header) + count * sizeof(snapshot_entry));
+    for (size_t i = 0; i < cache->capacity; i++) {
+        const tree_cache_entry *entry = &cache->entries[i];
+        if (entry->valid && owner_layer(sk, entry->owner) >= 0) {
+            size += align_up(tree_bytes(entry->tree.height));
+        }
+    }
+
+    uint8_t *file = calloc(1, size);
+    if (!file) return SNAPSHOT_OUT_OF_MEMORY;
+
+    snapshot_header *header = (snapshot_header *)file;
+    snapshot_entry *table = (snapshot_entry *)(file + sizeof(*header));
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+    header->hash_id = (uint32_t)sk->hash_id;
+    header->entry_count = (uint32_t)count;
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        header->idx[i] = sk->xmss_sk[i].idx;
+    }
+    header->file_size = size;
+    memcpy(header->pub_seed, sk->pub_seed, HASH_BYTES);
+    memcpy(header->pk_root, pk->root, HASH_BYTES);
+
+    size_t offset = align_up(sizeof(*header) + count * sizeof(*table));
+    size_t n = 0;
+    for (size_t i = 0; i < cache->capacity; i++) {
+        const tree_cache_entry *entry = &cache->entries[i];
+        int layer = entry->valid ? owner_layer(sk, entry->owner) : -1;
+        if (layer < 0) continue;
+
+        table[n].layer = (uint32_t)layer;
+        table[n].tree_id = entry->tree_id;
+        table[n].height = (uint32_t)entry->tree.height;
+        table[n].offset = offset;
+        memcpy(file + offset, entry->tree.nodes, tree_bytes(entry->tree.height));
+        offset += align_up(tree_bytes(entry->tree.height));
+        n++;
+    }
+    compute_mac(sk, file, size, header->mac);
+
+    // Write beside the target and rename, so the old snapshot stays
+    // intact until the new one is complete on disk
+    char *tmp = malloc(strlen(path) + 5);
+    int ret = tmp ? SNAPSHOT_IO_ERROR : SNAPSHOT_OUT_OF_MEMORY;
+    if (tmp) {
+        sprintf(tmp, "%s.tmp", path);
+        FILE *f = fopen(tmp, "wb");
+        if (f) {
+            int ok = fwrite(file, 1, size, f) == size && fflush(f) == 0 && fsync(fileno(f)) == 0;
+            ok = fclose(f) == 0 && ok;
+            if (ok && rename(tmp, path) == 0) {
+                ret = SNAPSHOT_SUCCESS;
+            } else {
+                remove(tmp);
+            }
+        }
+    }
+    free(tmp);
+    free(file);
+    return ret;
+}
+
+// Check one table entry's shape and bounds and copy its nodes into a tree
+// allocated like the rest of the cache
+static int copy_entry(const snapshot_entry *entry, const uint8_t *file, size_t size, size_t data_start, sphincs_arena *arena, merkle_tree *tree) {
+    int top = entry->tree_id == XMSS_TOP_TREE;
+    uint32_t height = top ? XMSS_TOP_HEIGHT : XMSS_SUBTREE_HEIGHT;
+
+    if (entry->layer >= HYPER_LAYERS || entry->height != height) return SNAPSHOT_BAD_FORMAT;
+    if (!top && entry->tree_id >= (1u << XMSS_TOP_HEIGHT)) return SNAPSHOT_BAD_FORMAT;
+    if (entry->offset % MERKLE_ALIGN != 0 || entry->offset < data_start ||
+        entry->offset > size || size - entry->offset < tree_bytes((int)height)) {
+        return SNAPSHOT_BAD_FORMAT;
+    }
+    if (merkle_tree_alloc(tree, (int)height, arena) != MERKLE_SUCCESS) return SNAPSHOT_OUT_OF_MEMORY;
+    memcpy(tree->nodes, file + entry->offset, tree_bytes((int)height));
+    return SNAPSHOT_SUCCESS;
+}
+
+// Copy every tree into trees (zeroed by the caller, which frees them on
+// failure) and check it
+static int load_trees(const sphincs_signer *signer, const sphincs_public_key *pk, const snapshot_entry *table,
+                      uint32_t count, const uint8_t *file, size_t size, merkle_tree *trees) {
+    const sphincs_hash_ctx *ctx = &signer->hash;
+    size_t data_start = sizeof(snapshot_header) + count * sizeof(snapshot_entry);
+    const merkle_tree *top[HYPER_LAYERS] = { NULL };
+
+    for (uint32_t i = 0; i < count; i++) {
+        int ret = copy_entry(&table[i], file, size, data_start, signer->trees.arena, &trees[i]);
+        if (ret != SNAPSHOT_SUCCESS) return ret;
+        if (merkle_tree_check(ctx, &trees[i]) != MERKLE_SUCCESS) return SNAPSHOT_INTEGRITY;
+
+        // A top tree must hash to its layer's root in the public key
+        if (table[i].tree_id == XMSS_TOP_TREE) {
+            if (top[table[i].layer]) return SNAPSHOT_BAD_FORMAT;
+            if (memcmp(merkle_root(&trees[i]), pk->xmss_pk[table[i].layer].root, HASH_BYTES) != 0) {
+                return SNAPSHOT_INTEGRITY;
+            }
+            top[table[i].layer] = &trees[i];
+        }
+    }
+
+    // A subtree's root is a leaf of its layer's top tree, so it can only be
+    // trusted when that top tree came along
+    for (uint32_t i = 0; i < count; i++) {
+        const merkle_tree *layer_top = top[table[i].layer];
+        if (table[i].tree_id == XMSS_TOP_TREE) continue;
+        if (!layer_top || memcmp(merkle_root(&trees[i]), merkle_node(layer_top, 0, table[i].tree_id), HASH_BYTES) != 0) {
+            return SNAPSHOT_INTEGRITY;
+        }
+    }
+    return SNAPSHOT_SUCCESS;
+}
+
+static int check_file(const sphincs_signer *signer, const sphincs_public_key *pk, const uint8_t *file, size_t size) {
+    const snapshot_header *header = (const snapshot_header *)file;
+    const sphincs_secret_key *sk = signer->sk;
+    uint8_t mac[HASH_BYTES];
+
+    if (size < sizeof(*header) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER ||
+        header->file_size != size ||
+        header->entry_count > (size - sizeof(*header)) / sizeof(snapshot_entry)) {
+        return SNAPSHOT_BAD_FORMAT;
+    }
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (header->idx[i] > (1u << XMSS_HEIGHT)) return SNAPSHOT_BAD_FORMAT;
+    }
+    // Checked before the MAC only to tell a foreign file from a damaged one
+    if (header->hash_id != (uint32_t)sk->hash_id || pk->hash_id != sk->hash_id ||
+        memcmp(header->pub_seed, sk->pub_seed, HASH_BYTES) != 0 ||
+        memcmp(pk->pub_seed, sk->pub_seed, HASH_BYTES) != 0 ||
+        memcmp(header->pk_root, pk->root, HASH_BYTES) != 0) {
+        return SNAPSHOT_KEY_MISMATCH;
+    }
+    compute_mac(sk, file, size, mac);
+    if (!same_mac(mac, header->mac)) {
+        return SNAPSHOT_MAC_MISMATCH;
+    }
+
+    // The layer roots the trees are checked against must be pk's own
+    sphincs_prepared_pk prepared;
+    if (sphincs_prepare_pk(&prepared, pk) != 0) {
+        return SNAPSHOT_INTEGRITY;
+    }
+    return SNAPSHOT_SUCCESS;
+}
+
+int sphincs_signer_load_snapshot(sphincs_signer *signer, const sphincs_public_key *pk, const char *path) {
+    if (!signer || !pk || !path) return SNAPSHOT_NULL_POINTER;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return SNAPSHOT_IO_ERROR;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return SNAPSHOT_IO_ERROR;
+    }
+    if (st.st_size <= 0) {
+        close(fd);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t *file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) return SNAPSHOT_IO_ERROR;
+
+    const snapshot_header *header = (const snapshot_header *)file;
+    const snapshot_entry *table = (const snapshot_entry *)(file + sizeof(*header));
+    uint32_t count = 0;
+    merkle_tree *trees = NULL;
+    int ret = check_file(signer, pk, file, size);
+    if (ret == SNAPSHOT_SUCCESS) {
+        count = header->entry_count;
+        trees = calloc(count > 0 ? count : 1, sizeof(*trees));
+        ret = trees ? load_trees(signer, pk, table, count, file, size, trees) : SNAPSHOT_OUT_OF_MEMORY;
+    }
+    if (ret != SNAPSHOT_SUCCESS) {
+        for (uint32_t i = 0; trees && i < count; i++) {
+            merkle_tree_free(&trees[i]);
+        }
+        free(trees);
+        munmap(file, size);
+        return ret;
+    }
+
+    // Never move an index back: the snapshot may predate signatures the
+    // key has made since, but it may also be newer than a restored key
+    for (int i = 0; i < HYPER_LAYERS; i++) {
+        if (header->idx[i] > signer->sk->xmss_sk[i].idx) {
+            signer->sk->xmss_sk[i].idx = header->idx[i];
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *owner = signer->sk->xmss_sk[table[i].layer].sk;
+        if (!tree_cache_lookup(&signer->trees, owner, table[i].tree_id)) {
+            tree_cache_store(&signer->trees, owner, table[i].tree_id, &trees[i]);
+        }
+        merkle_tree_free(&trees[i]); // Only still set if the cache had it already
+    }
+    free(trees);
+    munmap(file, size);
+    return SNAPSHOT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sphincs.h"
+
+#define SNAPSHOT_VERSION 2
+
+// Constants for error codes
+#define SNAPSHOT_SUCCESS 0
+#define SNAPSHOT_NULL_POINTER -1
+#define SNAPSHOT_IO_ERROR -2
+#define SNAPSHOT_BAD_FORMAT -3 // Wrong magic, version, byte order or size
+#define SNAPSHOT_MAC_MISMATCH -4 // Damaged, or not written with this secret key
+#define SNAPSHOT_KEY_MISMATCH -5 // Written for a different key
+#define SNAPSHOT_INTEGRITY -6    // Trees do not hash up to the public root
+#define SNAPSHOT_OUT_OF_MEMORY -8
+
+// Trust model: a snapshot is authenticated with HMAC-SHA256 under a key
+// derived from the layer seeds of the secret key, so only a holder of that
+// key can write a file it will load. Anyone with write access to the file
+// but not the key can destroy it (load fails and the signer rebuilds its
+// trees) but cannot make the signer adopt their trees or indices. A
+// snapshot written by the key holder is trusted like the key itself; the
+// indices it carries are still capped at 2^XMSS_HEIGHT and only ever move
+// the signer's indices forward.
+
+// Write the trees in signer's cache and its leaf indices to path. The file
+// is written next to path and renamed over it, so readers never see a
+// partial snapshot. It holds no secret key material: trees are listed by
+// hypertree layer, not by the seed that owns them, and the MAC key cannot
+// be recovered from the MAC.
+// Signing changes both the cache and the indices, so nothing may sign with
+// signer during the call; a running sign service saves through
+// sphincs_sign_service_save_snapshot, which holds its key lock.
+int sphincs_signer_save_snapshot(const sphincs_signer *signer, const sphincs_public_key *pk, const char *path);
+
+// Copy the trees of a snapshot written for pk into signer's cache, from
+// the cache's arena. Before anything is stored the file's MAC is
+// verified, every tree is rehashed from its leaves, top trees are matched
+// against the layer roots in pk and subtrees against their top tree.
+// Indices only ever move forward, so a stale snapshot cannot make the
+// signer reuse a leaf. Call before signing starts, e.g. before handing
+// the key to a sign service; the file is unmapped before returning.
+int sphincs_signer_load_snapshot(sphincs_signer *signer, const sphincs_public_key *pk, const char *path);
+
+#endif // SNAPSHOT_H
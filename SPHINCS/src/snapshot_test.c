@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "test_util.h"
+
+static char path[64];
+
+/* Sign a few messages so the cache holds every layer's top tree and the
+   bottom subtree in use */
+static int sign_some(sphincs_signer* signer, sphincs_secret_key* sk) {
+    static sphincs_signature sig;
+    int ok = sphincs_signer_init(signer, sk, SPHINCS_DEFAULT_CACHED_TREES, NULL) == 0;
+
+    for (int i = 0; i < 3 && ok; ++i) {
+        ok &= sphincs_signer_sign(signer, &sig, (const uint8_t*)"snapshot", 8) == 0;
+    }
+    return ok;
+}
+
+static int save_signed(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    sphincs_signer signer;
+    int ok = sign_some(&signer, sk) && sphincs_signer_save_snapshot(&signer, pk, path) == SNAPSHOT_SUCCESS;
+    sphincs_signer_free(&signer);
+    return ok;
+}
+
+/* Load into a fresh signer for a copy of sk whose indices start at 0 */
+static int load_fresh(const sphincs_secret_key* sk, const sphincs_public_key* pk, sphincs_secret_key* fresh, sphincs_signer* signer) {
+    *fresh = *sk;
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        fresh->xmss_sk[i].idx = 0;
+    }
+    if (sphincs_signer_init(signer, fresh, SPHINCS_DEFAULT_CACHED_TREES, NULL) != 0) {
+        return SNAPSHOT_OUT_OF_MEMORY;
+    }
+    return sphincs_signer_load_snapshot(signer, pk, path);
+}
+
+static size_t cached(const sphincs_signer* signer) {
+    size_t n = 0;
+    for (size_t i = 0; i < signer->trees.capacity; ++i) {
+        n += signer->trees.entries[i].valid;
+    }
+    return n;
+}
+
+/* Flip the low bit of the saved file's last byte, inside the last tree */
+static int flip_last_byte(void) {
+    struct stat st;
+    FILE* f = stat(path, &st) == 0 ? fopen(path, "r+b") : NULL;
+    int c, ok = f != NULL;
+
+    ok = ok && fseek(f, (long)st.st_size - 1, SEEK_SET) == 0 && (c = fgetc(f)) != EOF;
+    ok = ok && fseek(f, (long)st.st_size - 1, SEEK_SET) == 0 && fputc(c ^ 1, f) != EOF;
+    if (f) {
+        ok &= fclose(f) == 0;
+    }
+    return ok;
+}
+
+/* Overwrite the header's first leaf index (after the magic and four
+   32-bit fields) */
+static int write_index(uint32_t idx) {
+    FILE* f = fopen(path, "r+b");
+    int ok = f != NULL;
+
+    ok = ok && fseek(f, 24, SEEK_SET) == 0 && fwrite(&idx, sizeof(idx), 1, f) == 1;
+    if (f) {
+        ok &= fclose(f) == 0;
+    }
+    return ok;
+}
+
+/* Trees come back identical, owned by the cache, and the indices move
+   forward to the saved ones */
+static void test_round_trip(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    static sphincs_secret_key fresh;
+    sphincs_signer saved, loaded;
+    int ok = sign_some(&saved, sk) && sphincs_signer_save_snapshot(&saved, pk, path) == SNAPSHOT_SUCCESS;
+
+    ok = ok && load_fresh(sk, pk, &fresh, &loaded) == SNAPSHOT_SUCCESS;
+    if (!ok) {
+        report("Snapshot round trip", 0);
+        return;
+    }
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        ok &= fresh.xmss_sk[i].idx == sk->xmss_sk[i].idx;
+    }
+    ok &= cached(&loaded) == cached(&saved);
+    for (size_t i = 0; i < saved.trees.capacity; ++i) {
+        const tree_cache_entry* entry = &saved.trees.entries[i];
+        if (!entry->valid) continue;
+        merkle_tree* copy = tree_cache_lookup(&loaded.trees, entry->owner, entry->tree_id);
+        ok &= copy && copy->nodes != entry->tree.nodes && copy->height == entry->tree.height;
+        ok = ok && memcmp(copy->nodes, entry->tree.nodes, (size_t)MERKLE_NODES(copy->height) * HASH_BYTES) == 0;
+    }
+    sphincs_signer_free(&saved);
+
+    // Loading again keeps the trees already cached and frees the copies
+    ok &= sphincs_signer_load_snapshot(&loaded, pk, path) == SNAPSHOT_SUCCESS;
+    ok &= cached(&loaded) == 2 * HYPER_LAYERS;
+    sphincs_signer_free(&loaded);
+    report("Snapshot round trip", ok);
+}
+
+/* Each damaged or foreign file is rejected with its own code and leaves
+   the loading signer's cache and indices untouched */
+static void test_rejects(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    static sphincs_public_key other_pk;
+    static sphincs_secret_key other_sk, fresh;
+    uint8_t other_seed[HASH_BYTES] = { 0x77 };
+    sphincs_signer signer;
+    int ok = 1;
+
+    ok &= save_signed(sk, pk) && flip_last_byte();
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_MAC_MISMATCH;
+    ok &= cached(&signer) == 0 && fresh.xmss_sk[0].idx == 0;
+    sphincs_signer_free(&signer);
+    report("Snapshot bad MAC", ok);
+
+    // Indices are covered by the MAC, and past the end of a layer they
+    // are rejected outright
+    ok = save_signed(sk, pk) && write_index(sk->xmss_sk[0].idx + 100);
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_MAC_MISMATCH;
+    ok &= fresh.xmss_sk[0].idx == 0;
+    sphincs_signer_free(&signer);
+    ok &= save_signed(sk, pk) && write_index(0xFFFFFFFFu);
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_BAD_FORMAT;
+    ok &= fresh.xmss_sk[0].idx == 0;
+    sphincs_signer_free(&signer);
+    report("Snapshot forged index", ok);
+
+    // Written for a different key
+    ok = sphincs_keygen(&other_pk, &other_sk, other_seed) == 0;
+    ok = ok && save_signed(&other_sk, &other_pk);
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_KEY_MISMATCH;
+    ok &= cached(&signer) == 0;
+    sphincs_signer_free(&signer);
+    report("Snapshot wrong key", ok);
+
+    // Cut inside the entry table
+    ok = save_signed(sk, pk) && truncate(path, 200) == 0;
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_BAD_FORMAT;
+    ok &= cached(&signer) == 0;
+    sphincs_signer_free(&signer);
+    report("Snapshot truncated table", ok);
+}
+
+/* A well formed subtree that is not the one the top tree commits to:
+   it rehashes fine on its own, so only the root match catches it */
+static void test_subtree_mismatch(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    static sphincs_secret_key fresh;
+    static sphincs_signature sig;
+    sphincs_signer signer;
+    merkle_tree bogus;
+    int ok = sphincs_signer_init(&signer, sk, SPHINCS_DEFAULT_CACHED_TREES + 1, NULL) == 0;
+
+    ok = ok && sphincs_signer_sign(&signer, &sig, (const uint8_t*)"snapshot", 8) == 0;
+    ok = ok && merkle_tree_alloc(&bogus, XMSS_SUBTREE_HEIGHT, NULL) == MERKLE_SUCCESS;
+    if (!ok) {
+        report("Snapshot subtree mismatch", 0);
+        return;
+    }
+    memset(bogus.nodes, 0x5A, (size_t)MERKLE_NODES(XMSS_SUBTREE_HEIGHT) * HASH_BYTES);
+    merkle_tree_build(&signer.hash, &bogus);
+    tree_cache_store(&signer.trees, sk->xmss_sk[0].sk, (1u << XMSS_TOP_HEIGHT) - 1, &bogus);
+    ok &= sphincs_signer_save_snapshot(&signer, pk, path) == SNAPSHOT_SUCCESS;
+    sphincs_signer_free(&signer);
+
+    ok &= load_fresh(sk, pk, &fresh, &signer) == SNAPSHOT_INTEGRITY;
+    ok &= cached(&signer) == 0;
+    sphincs_signer_free(&signer);
+    report("Snapshot subtree mismatch", ok);
+}
+
+int main() {
+    static sphincs_public_key pk;
+    static sphincs_secret_key sk;
+    uint8_t seed[HASH_BYTES] = { 0x19 };
+
+    snprintf(path, sizeof(path), "/tmp/snapshot_test.%d", (int)getpid());
+    if (sphincs_keygen(&pk, &sk, seed) != 0) {
+        report("Snapshot keygen", 0);
+        return 1;
+    }
+    test_round_trip(&sk, &pk);
+    test_rejects(&sk, &pk);
+    test_subtree_mismatch(&sk, &pk);
+    remove(path);
+    return test_status();
+}
@@ -1,36 +1,283 @@
 #include <stdlib.h>
 #include "sphincs.h"
+#include "rng.h"
+#include "offline.h"
 #include <string.h>
 
-void sphincs_keygen(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed) {
-    fors_keygen(&pk->fors_pk, &sk->fors_sk, seed);
+int sphincs_keygen(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed) {
+    return sphincs_keygen_with_hash(pk, sk, seed, SPHINCS_HASH_SHA256);
+}
+
+int sphincs_keygen_with_hash(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed, sphincs_hash_id hash_id) {
+    sphincs_hash_ctx ctx;
+
+    // The public seed keys every tweakable hash of this key pair
+    rng_init(seed);
+    rng_generate(pk->pub_seed, HASH_BYTES);
+    memcpy(sk->pub_seed, pk->pub_seed, HASH_BYTES);
+    pk->hash_id = hash_id;
+    sk->hash_id = hash_id;
+
+    int ret = hash_ctx_init(&ctx, hash_id, pk->pub_seed);
+    if (ret != HASH_SUCCESS) {
+        return ret;
+    }
+
+    ret = fors_keygen(&ctx, &pk->fors_public_key, &sk->fors_secret_key, seed);
+    if (ret != 0) {
+        return ret;
+    }
+    // Every layer's root is built here, not just the top one: pk->root
+    // hashes all of them and verification checks each layer against its
+    // own, so there is no lazy keygen (see sphincs.h)
     for (int i = 0; i < HYPER_LAYERS; ++i) {
-        xmss_keygen(&pk->xmss_pk[i], &sk->xmss_sk[i], seed);
+        ret = xmss_keygen(&ctx, &pk->xmss_pk[i], &sk->xmss_sk[i], seed);
+        if (ret != 0) {
+            return ret;
+        }
     }
-    hypertree_compute_root(pk->root, pk->xmss_pk);
+    hypertree_compute_root(&ctx, pk->root, pk->xmss_pk);
+    return 0;
 }
 
-void sphincs_sign(sphincs_signature *sig, const uint8_t *msg, const sphincs_secret_key *sk) {
-    uint8_t hashed_msg[HASH_BYTES];
-    sha256(msg, strlen(msg), hashed_msg);
-    fors_sign(&sig->fors_sig, hashed_msg, &sk->fors_sk);
+int sphincs_sign(sphincs_signature *sig, const uint8_t *msg, size_t msglen, sphincs_secret_key *sk) {
+    sphincs_hash_ctx ctx;
+    int ret = hash_ctx_init(&ctx, sk->hash_id, sk->pub_seed);
+    if (ret != HASH_SUCCESS) {
+        return ret;
+    }
+    return sphincs_sign_with_ctx(&ctx, sig, msg, msglen, sk);
+}
+
+// Use the hypertree signatures precomputed for sk's next indices, if any,
+// advancing the indices as xmss_sign would have
+static int take_precomputed(sphincs_offline *offline, sphincs_secret_key *sk, xmss_multitree_signature *sigs) {
+    if (!offline || !sphincs_offline_take(offline, sk, sigs)) {
+        return 0;
+    }
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        sk->xmss_sk[i].idx++;
+    }
+    return 1;
+}
+
+// The message-dependent part of a signature; reads sk but never changes it
+static int sign_fors(const sphincs_hash_ctx *ctx, fors_signature *fors_sig, uint8_t *digest, const uint8_t *msg, size_t msglen, const sphincs_secret_key *sk) {
+    hash_h_msg(ctx, digest, msg, msglen);
+    return fors_sign(ctx, fors_sig, digest, &sk->fors_secret_key);
+}
+
+// Receives each finished layer signature in order; non-zero stops signing
+typedef int (*layer_sink)(int layer, const xmss_multitree_signature *sig, void *user);
+
+// The hypertree part, which advances sk's indices. Layers come from the
+// offline ring when it has them, otherwise they are signed one at a time;
+// precomputed must hold HYPER_LAYERS signatures.
+static int sign_layers(const sphincs_hash_ctx *ctx, tree_cache *cache, sphincs_offline *offline, const uint8_t *digest, sphincs_secret_key *sk,
+                       xmss_multitree_signature *precomputed, layer_sink sink, void *user) {
+    int have_precomputed = take_precomputed(offline, sk, precomputed);
     for (int i = 0; i < HYPER_LAYERS; ++i) {
-        xmss_sign(&sig->xmss_sig[i], hashed_msg, &sk->xmss_sk[i]);
+        xmss_multitree_signature xmss_sig;
+        const xmss_multitree_signature *layer = &precomputed[i];
+        if (!have_precomputed) {
+            int ret = xmss_sign(ctx, &xmss_sig, digest, &sk->xmss_sk[i], cache);
+            if (ret != 0) {
+                return ret;
+            }
+            layer = &xmss_sig;
+        }
+        int ret = sink(i, layer, user);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+static int store_layer(int layer, const xmss_multitree_signature *xmss_sig, void *user) {
+    sphincs_signature *sig = user;
+    sig->xmss_sig[layer] = *xmss_sig;
+    return 0;
+}
+
+static int sign_layers_into(const sphincs_hash_ctx *ctx, tree_cache *cache, sphincs_offline *offline, sphincs_signature *sig, const uint8_t *digest, sphincs_secret_key *sk) {
+    // Precomputed layers land in place; store_layer then copies each onto itself
+    return sign_layers(ctx, cache, offline, digest, sk, sig->xmss_sig, store_layer, sig);
+}
+
+static int sign_with_cache(const sphincs_hash_ctx *ctx, tree_cache *cache, sphincs_offline *offline, sphincs_signature *sig, const uint8_t *msg, size_t msglen, sphincs_secret_key *sk) {
+    uint8_t hashed_msg[HASH_BYTES];
+    int ret = sign_fors(ctx, &sig->fors_signature, hashed_msg, msg, msglen, sk);
+    if (ret != 0) {
+        return ret;
+    }
+    return sign_layers_into(ctx, cache, offline, sig, hashed_msg, sk);
+}
+
+int sphincs_sign_with_ctx(const sphincs_hash_ctx *ctx, sphincs_signature *sig, const uint8_t *msg, size_t msglen, sphincs_secret_key *sk) {
+    return sign_with_cache(ctx, NULL, NULL, sig, msg, msglen, sk);
+}
+
+sphincs_secret_key *sphincs_secret_key_new(sphincs_arena *arena) {
+    sphincs_secret_key *sk = arena ? sphincs_arena_alloc(arena, sizeof(*sk)) : malloc(sizeof(*sk));
+    if (sk) {
+        memset(sk, 0, sizeof(*sk));
+    }
+    return sk;
+}
+
+void sphincs_secret_key_free(sphincs_arena *arena, sphincs_secret_key *sk) {
+    if (!sk) return;
+    if (arena) {
+        sphincs_arena_free(arena, sk); // Wipes the block
+    } else {
+        sphincs_wipe(sk, sizeof(*sk));
+        free(sk);
+    }
+}
+
+int sphincs_signer_init(sphincs_signer *signer, sphincs_secret_key *sk, size_t cached_trees, sphincs_arena *arena) {
+    int ret = hash_ctx_init(&signer->hash, sk->hash_id, sk->pub_seed);
+    if (ret != HASH_SUCCESS) {
+        return ret;
     }
+    ret = tree_cache_init(&signer->trees, cached_trees, arena);
+    if (ret != TREE_CACHE_SUCCESS) {
+        return ret;
+    }
+    signer->sk = sk;
+    signer->offline = NULL;
+    return 0;
+}
+
+void sphincs_signer_free(sphincs_signer *signer) {
+    sphincs_signer_stop_offline(signer);
+    tree_cache_free(&signer->trees);
+}
+
+int sphincs_signer_sign(sphincs_signer *signer, sphincs_signature *sig, const uint8_t *msg, size_t msglen) {
+    return sign_with_cache(&signer->hash, &signer->trees, signer->offline, sig, msg, msglen, signer->sk);
+}
+
+int sphincs_signer_sign_fors(const sphincs_signer *signer, sphincs_signature *sig, uint8_t *digest, const uint8_t *msg, size_t msglen) {
+    return sign_fors(&signer->hash, &sig->fors_signature, digest, msg, msglen, signer->sk);
+}
+
+int sphincs_signer_sign_layers(sphincs_signer *signer, sphincs_signature *sig, const uint8_t *digest) {
+    return sign_layers_into(&signer->hash, &signer->trees, signer->offline, sig, digest, signer->sk);
+}
+
+// Wire encodings of the streamed sections (see SPHINCS_SIG_BYTES)
+static void encode_fors(const fors_signature *fors_sig, uint8_t *out) {
+    for (int i = 0; i < FORS_K; ++i) {
+        memcpy(out, fors_sig->signatures[i].sig, HASH_BYTES);
+        memcpy(out + HASH_BYTES, fors_sig->signatures[i].auth_path, FORS_HEIGHT * HASH_BYTES);
+        out += (1 + FORS_HEIGHT) * HASH_BYTES;
+    }
+}
+
+static void encode_layer(const xmss_multitree_signature *xmss_sig, uint8_t *out) {
+    out[0] = (xmss_sig->leaf_idx >> 24) & 0xFF;
+    out[1] = (xmss_sig->leaf_idx >> 16) & 0xFF;
+    out[2] = (xmss_sig->leaf_idx >> 8) & 0xFF;
+    out[3] = xmss_sig->leaf_idx & 0xFF;
+    memcpy(out + 4, xmss_sig->leaf, HASH_BYTES);
+    memcpy(out + 4 + HASH_BYTES, xmss_sig->auth_path, XMSS_HEIGHT * HASH_BYTES);
+}
+
+// Working state of one streamed signature, too large for the stack
+typedef struct {
+    fors_signature fors_sig;
+    xmss_multitree_signature precomputed[HYPER_LAYERS];
+    uint8_t wire[SPHINCS_FORS_SIG_BYTES]; // Holds one section at a time
+    sphincs_signature_sink sink;
+    void *user;
+} stream_state;
+
+static int stream_layer(int layer, const xmss_multitree_signature *xmss_sig, void *user) {
+    stream_state *state = user;
+    (void)layer;
+    encode_layer(xmss_sig, state->wire);
+    return state->sink(state->wire, SPHINCS_LAYER_SIG_BYTES, state->user) != 0 ? SPHINCS_SINK_ABORTED : 0;
+}
+
+static int sign_stream(sphincs_signer *signer, stream_state *state, const uint8_t *msg, size_t msglen) {
+    uint8_t hashed_msg[HASH_BYTES];
+    int ret = sign_fors(&signer->hash, &state->fors_sig, hashed_msg, msg, msglen, signer->sk);
+    if (ret != 0) {
+        return ret;
+    }
+    encode_fors(&state->fors_sig, state->wire);
+    if (state->sink(state->wire, SPHINCS_FORS_SIG_BYTES, state->user) != 0) {
+        return SPHINCS_SINK_ABORTED;
+    }
+    return sign_layers(&signer->hash, &signer->trees, signer->offline, hashed_msg, signer->sk, state->precomputed, stream_layer, state);
+}
+
+int sphincs_signer_sign_stream(sphincs_signer *signer, const uint8_t *msg, size_t msglen, sphincs_signature_sink sink, void *user) {
+    sphincs_arena *arena = signer->trees.arena;
+    stream_state *state = arena ? sphincs_arena_alloc(arena, sizeof(*state)) : malloc(sizeof(*state));
+    if (!state) {
+        return SPHINCS_OUT_OF_MEMORY;
+    }
+    state->sink = sink;
+    state->user = user;
+
+    int ret = sign_stream(signer, state, msg, msglen);
+    if (arena) {
+        sphincs_arena_free(arena, state); // Wipes the block
+    } else {
+        sphincs_wipe(state, sizeof(*state));
+        free(state);
+    }
+    return ret;
 }
 
-int sphincs_verify(const sphincs_signature *sig, const uint8_t *msg, const sphincs_public_key *pk) {
+int sphincs_verify(const sphincs_signature *sig, const uint8_t *msg, size_t msglen, const sphincs_public_key *pk) {
+    sphincs_prepared_pk prepared;
+    if (sphincs_prepare_pk(&prepared, pk) != 0) {
+        return 0;
+    }
+    return sphincs_verify_prepared(sig, msg, msglen, &prepared);
+}
+
+int sphincs_prepare_pk(sphincs_prepared_pk *prepared, const sphincs_public_key *pk) {
+    if (!prepared || !pk) {
+        return SPHINCS_NULL_POINTER;
+    }
+    int ret = hash_ctx_init(&prepared->hash, pk->hash_id, pk->pub_seed);
+    if (ret != HASH_SUCCESS) {
+        return ret;
+    }
+
+    // The layer roots are part of the key, so the root check is too
+    uint8_t computed_root[HASH_BYTES];
+    hypertree_compute_root(&prepared->hash, computed_root, pk->xmss_pk);
+    if (memcmp(computed_root, pk->root, HASH_BYTES) != 0) {
+        return SPHINCS_INVALID_PUBLIC_KEY;
+    }
+
+    prepared->pk = *pk;
+    return 0;
+}
+
+int sphincs_verify_prepared(const sphincs_signature *sig, const uint8_t *msg, size_t msglen, const sphincs_prepared_pk *prepared) {
+    if (!sig || (!msg && msglen > 0) || !prepared) {
+        return SPHINCS_NULL_POINTER;
+    }
+    const sphincs_hash_ctx *ctx = &prepared->hash;
+    const sphincs_public_key *pk = &prepared->pk;
+
     uint8_t hashed_msg[HASH_BYTES];
-    sha256(msg, strlen(msg), hashed_msg);
-    if (!fors_verify(&sig->fors_sig, hashed_msg, &pk->fors_pk)) {
+    hash_h_msg(ctx, hashed_msg, msg, msglen);
+    // Both return 1 only for a valid signature
+    if (fors_verify(ctx, &sig->fors_signature, hashed_msg, &pk->fors_public_key) != 1) {
         return 0;
     }
     for (int i = 0; i < HYPER_LAYERS; ++i) {
-        if (!xmss_verify(&sig->xmss_sig[i], hashed_msg, &pk->xmss_pk[i])) {
+        if (xmss_verify(ctx, &sig->xmss_sig[i], hashed_msg, &pk->xmss_pk[i]) != 1) {
             return 0;
         }
     }
-    uint8_t computed_root[HASH_BYTES];
-    hypertree_compute_root(computed_root, pk->xmss_pk);
-    return memcmp(computed_root, pk->root, HASH_BYTES) == 0;
+    return 1;
 }
@@ -6,13 +6,16 @@
 #include <string.h>
 #include "fors.h" // Assuming FORS is already defined
 #include "xmss.h" // Assuming XMSS is already defined
-#include "sha256.h"
+#include "hypertree.h"
+#include "hash.h"
 
-#define HYPER_LAYERS 5 // Number of layers in the hypertree
+#define HYPER_LAYERS HYPERTREE_LAYERS // Number of layers in the hypertree
 #define HASH_BYTES 32 // Hash size in bytes
 
 // SPHINCS+ public key structure
 typedef struct {
+    sphincs_hash_id hash_id;
+    uint8_t pub_seed[HASH_BYTES];
     fors_public_key fors_public_key;
     xmss_multitree_public_key xmss_pk[HYPER_LAYERS];
     uint8_t root[HASH_BYTES];
@@ -20,6 +23,8 @@ typedef struct {
 
 // SPHINCS+ secret key structure
 typedef struct {
+    sphincs_hash_id hash_id;
+    uint8_t pub_seed[HASH_BYTES];
     fors_secret_key fors_secret_key;
     xmss_multitree_secret_key xmss_sk[HYPER_LAYERS];
 } sphincs_secret_key;
@@ -30,9 +35,102 @@ typedef struct {
     xmss_multitree_signature xmss_sig[HYPER_LAYERS];
 } sphincs_signature;
 
+// Public key checked once and bound to a ready hash context (seed midstate
+// or tweaked Haraka constants), for verifiers that reuse the same key.
+typedef struct {
+    sphincs_public_key pk;
+    sphincs_hash_ctx hash;
+} sphincs_prepared_pk;
+
+// Background precomputation of upcoming hypertree signatures (offline.h)
+typedef struct sphincs_offline sphincs_offline;
+
+// Signing state for one secret key: its hash context and a bounded cache
+// of XMSS trees. Trees are built the first time a signature needs them
+// rather than on every signature, and evicted least recently used first.
+typedef struct {
+    sphincs_secret_key *sk;
+    sphincs_hash_ctx hash;
+    tree_cache trees;
+    sphincs_offline *offline; // NULL unless started with sphincs_signer_start_offline
+} sphincs_signer;
+
+// One bottom subtree and the top tree for every layer
+#define SPHINCS_DEFAULT_CACHED_TREES (2 * HYPER_LAYERS)
+
+// Error code returned when a required argument is NULL
+#define SPHINCS_NULL_POINTER -1
+// Error code returned when scratch memory cannot be allocated
+#define SPHINCS_OUT_OF_MEMORY -3
+// Error code returned when the layer roots do not hash to pk->root
+#define SPHINCS_INVALID_PUBLIC_KEY -4
+// Error code returned when a signature sink asks to stop
+#define SPHINCS_SINK_ABORTED -5
+
+// Receives the next chunk of a signature being streamed; a non-zero
+// return aborts signing.
+typedef int (*sphincs_signature_sink)(const uint8_t *data, size_t len, void *user);
+
+// Streamed sections, fixed size and free of padding or host byte order:
+//   FORS  - for each tree, the revealed secret then its FORS_HEIGHT
+//           auth path nodes
+//   layer - leaf_idx as 4 bytes big endian, the leaf, then its
+//           XMSS_HEIGHT auth path nodes; one per hypertree layer
+#define SPHINCS_FORS_SIG_BYTES (FORS_K * (1 + FORS_HEIGHT) * HASH_BYTES)
+#define SPHINCS_LAYER_SIG_BYTES (4 + (1 + XMSS_HEIGHT) * HASH_BYTES)
+#define SPHINCS_SIG_BYTES (SPHINCS_FORS_SIG_BYTES + HYPER_LAYERS * SPHINCS_LAYER_SIG_BYTES)
+
 // Function declarations
-void sphincs_keygen(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed);
-void sphincs_sign(sphincs_signature *sig, const uint8_t *msg, const sphincs_secret_key *sk);
-int sphincs_verify(const sphincs_signature *sig, const uint8_t *msg, const sphincs_public_key *pk);
+// Keygen is not lazy: it builds every layer's full XMSS tree, because
+// pk->root and verification cover all layer roots. Only the signer
+// defers work, building the subtrees a signature needs on first use.
+int sphincs_keygen(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed);
+// Same as sphincs_keygen but binds the key pair to the given hash backend.
+// Returns HASH_UNAVAILABLE if the backend cannot run on this machine.
+int sphincs_keygen_with_hash(sphincs_public_key *pk, sphincs_secret_key *sk, const uint8_t *seed, sphincs_hash_id hash_id);
+// Signs the msglen bytes at msg; messages are binary, not strings.
+// Signing advances sk's hypertree indices, so sk must not be shared
+// between concurrent calls.
+int sphincs_sign(sphincs_signature *sig, const uint8_t *msg, size_t msglen, sphincs_secret_key *sk);
+// Sign msglen bytes with a hash context already initialised for sk, so
+// callers signing many messages pay the backend setup once.
+int sphincs_sign_with_ctx(const sphincs_hash_ctx *ctx, sphincs_signature *sig, const uint8_t *msg, size_t msglen, sphincs_secret_key *sk);
+// 1 for a valid signature on the msglen bytes at msg, 0 otherwise
+int sphincs_verify(const sphincs_signature *sig, const uint8_t *msg, size_t msglen, const sphincs_public_key *pk);
+
+// Secret keys allocated from arena (or the heap when NULL) and wiped on free
+sphincs_secret_key *sphincs_secret_key_new(sphincs_arena *arena);
+void sphincs_secret_key_free(sphincs_arena *arena, sphincs_secret_key *sk);
+
+// The signer keeps a pointer to sk and advances its index as it signs.
+// Cached trees live in arena, or on the heap when it is NULL.
+int sphincs_signer_init(sphincs_signer *signer, sphincs_secret_key *sk, size_t cached_trees, sphincs_arena *arena);
+void sphincs_signer_free(sphincs_signer *signer);
+int sphincs_signer_sign(sphincs_signer *signer, sphincs_signature *sig, const uint8_t *msg, size_t msglen);
+// sphincs_signer_sign in two steps, for callers signing from several
+// threads. sphincs_signer_sign_fors digests msg into digest (HASH_BYTES)
+// and fills the FORS part of sig without touching the key's indices or
+// tree cache, so any number of calls may run at once.
+// sphincs_signer_sign_layers then fills the hypertree part from digest
+// and advances the indices; those calls must be serialised per signer.
+int sphincs_signer_sign_fors(const sphincs_signer *signer, sphincs_signature *sig, uint8_t *digest, const uint8_t *msg, size_t msglen);
+int sphincs_signer_sign_layers(sphincs_signer *signer, sphincs_signature *sig, const uint8_t *digest);
+// Sign and hand the signature to sink in its serialized order (the FORS
+// section, then each hypertree layer; see SPHINCS_SIG_BYTES above), each
+// section as soon as it is computed. Scratch state comes from the
+// signer's arena, or the heap without one. Returns 0,
+// SPHINCS_SINK_ABORTED when sink returns non-zero, SPHINCS_OUT_OF_MEMORY,
+// or the signing error, in which case sink never sees the failed section.
+// The key's indices stay advanced either way.
+int sphincs_signer_sign_stream(sphincs_signer *signer, const uint8_t *msg, size_t msglen, sphincs_signature_sink sink, void *user);
+
+// Validate pk and precompute its key-constant hash state. Returns 0,
+// SPHINCS_NULL_POINTER, a HASH_* error for an unusable backend, or
+// SPHINCS_INVALID_PUBLIC_KEY.
+int sphincs_prepare_pk(sphincs_prepared_pk *prepared, const sphincs_public_key *pk);
+// Same result as sphincs_verify, minus the per-call key set-up and root
+// check: 1 for a valid signature, 0 otherwise. NULL arguments return
+// SPHINCS_NULL_POINTER, so test for == 1 rather than for non-zero.
+int sphincs_verify_prepared(const sphincs_signature *sig, const uint8_t *msg, size_t msglen, const sphincs_prepared_pk *prepared);
 
 #endif // SPHINCS_H
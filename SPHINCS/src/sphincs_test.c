@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include "sphincs.h"
+#include "test_util.h"
+
+static uint8_t wire[SPHINCS_SIG_BYTES + 1];
+static size_t wire_len, sections;
+
+static int collect(const uint8_t* data, size_t len, void* user) {
+    (void)user;
+    if (wire_len + len > sizeof(wire)) return 1;
+    memcpy(wire + wire_len, data, len);
+    wire_len += len;
+    sections++;
+    return 0;
+}
+
+/* A message with embedded zero bytes is signed and verified in full */
+static void test_binary_message(sphincs_secret_key* sk, const sphincs_public_key* pk) {
+    static sphincs_signature sig;
+    const uint8_t msg[4] = { 'a', 0, 'b', 0 };
+    int ok = sphincs_sign(&sig, msg, sizeof(msg), sk) == 0;
+
+    ok &= sphincs_verify(&sig, msg, sizeof(msg), pk) == 1;
+    ok &= sphincs_verify(&sig, msg, 1, pk) == 0;
+    report("Sign binary message", ok);
+}
+
+/* The stream is the fixed-size encoding of the signature sphincs_signer_sign
+   makes for the same indices: FORS, then each layer with leaf_idx big endian */
+static void test_stream_format(sphincs_secret_key* sk) {
+    static sphincs_signature sig;
+    sphincs_signer signer;
+    uint32_t start[HYPER_LAYERS];
+    int ok = sphincs_signer_init(&signer, sk, SPHINCS_DEFAULT_CACHED_TREES, NULL) == 0;
+
+    sk->xmss_sk[1].idx = 0x102;
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        start[i] = sk->xmss_sk[i].idx;
+    }
+    ok = ok && sphincs_signer_sign_stream(&signer, (const uint8_t*)"stream", 6, collect, NULL) == 0;
+    ok &= wire_len == SPHINCS_SIG_BYTES && sections == 1 + HYPER_LAYERS;
+    for (int i = 0; i < HYPER_LAYERS; ++i) {
+        sk->xmss_sk[i].idx = start[i];
+    }
+    ok = ok && sphincs_signer_sign(&signer, &sig, (const uint8_t*)"stream", 6) == 0;
+    sphincs_signer_free(&signer);
+
+    for (int i = 0; i < FORS_K && ok; ++i) {
+        const uint8_t* tree = wire + i * (1 + FORS_HEIGHT) * HASH_BYTES;
+        ok &= memcmp(tree, sig.fors_signature.signatures[i].sig, HASH_BYTES) == 0;
+        ok &= memcmp(tree + HASH_BYTES, sig.fors_signature.signatures[i].auth_path, FORS_HEIGHT * HASH_BYTES) == 0;
+    }
+    for (int i = 0; i < HYPER_LAYERS && ok; ++i) {
+        const uint8_t* layer = wire + SPHINCS_FORS_SIG_BYTES + i * SPHINCS_LAYER_SIG_BYTES;
+        uint32_t leaf_idx = (uint32_t)layer[0] << 24 | (uint32_t)layer[1] << 16 | (uint32_t)layer[2] << 8 | layer[3];
+        ok &= leaf_idx == start[i] && leaf_idx == sig.xmss_sig[i].leaf_idx;
+        ok &= memcmp(layer + 4, sig.xmss_sig[i].leaf, HASH_BYTES) == 0;
+        ok &= memcmp(layer + 4 + HASH_BYTES, sig.xmss_sig[i].auth_path, XMSS_HEIGHT * HASH_BYTES) == 0;
+    }
+    report("Sign stream format", ok);
+}
+
+int main() {
+    static sphincs_public_key pk;
+    static sphincs_secret_key sk;
+    uint8_t seed[HASH_BYTES] = { 0x2D };
+
+    if (sphincs_keygen(&pk, &sk, seed) != 0) {
+        report("Sphincs keygen", 0);
+        return 1;
+    }
+    test_binary_message(&sk, &pk);
+    test_stream_format(&sk);
+    return test_status();
+}
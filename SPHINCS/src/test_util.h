@@ -0,0 +1,34 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Helpers shared by the *_test.c drivers. Each driver is one translation
+// unit, so these are static rather than a library of their own.
+
+static int test_failures;
+
+// Print one "<name> passed!" or "<name> failed!" line and count failures
+static void report(const char* name, int ok) {
+    test_failures += !ok;
+    printf("%s %s!\n", name, ok ? "passed" : "failed");
+}
+
+// Exit status for main: non-zero once any report failed, for ctest
+static int test_status(void) {
+    return test_failures != 0;
+}
+
+/* Function to compare two arrays of bytes */
+static int compare_bytes(const uint8_t* arr1, const uint8_t* arr2, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (arr1[i] != arr2[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#endif // TEST_UTIL_H
@@ -0,0 +1,83 @@
+#include "tree_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+int tree_cache_init(tree_cache *cache, size_t capacity, sphincs_arena *arena) {
+    if (!cache) return TREE_CACHE_NULL_POINTER;
+
+    capacity = capacity > 0 ? capacity : 1;
+    if (arena) {
+        cache->entries = sphincs_arena_alloc(arena, capacity * sizeof(*cache->entries));
+        if (cache->entries) {
+            memset(cache->entries, 0, capacity * sizeof(*cache->entries));
+        }
+    } else {
+        cache->entries = calloc(capacity, sizeof(*cache->entries));
+    }
+    if (!cache->entries) return TREE_CACHE_OUT_OF_MEMORY;
+    cache->arena = arena;
+    cache->capacity = capacity;
+    cache->clock = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    return TREE_CACHE_SUCCESS;
+}
+
+void tree_cache_free(tree_cache *cache) {
+    if (!cache || !cache->entries) return;
+
+    for (size_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i].valid) {
+            merkle_tree_free(&cache->entries[i].tree);
+        }
+    }
+    // Owners are secret seeds
+    sphincs_wipe(cache->entries, cache->capacity * sizeof(*cache->entries));
+    if (cache->arena) {
+        sphincs_arena_free(cache->arena, cache->entries);
+    } else {
+        free(cache->entries);
+    }
+    cache->entries = NULL;
+}
+
+merkle_tree *tree_cache_lookup(tree_cache *cache, const uint8_t *owner, uint32_t tree_id) {
+    for (size_t i = 0; i < cache->capacity; i++) {
+        tree_cache_entry *entry = &cache->entries[i];
+        if (entry->valid && entry->tree_id == tree_id && memcmp(entry->owner, owner, HASH_BYTES) == 0) {
+            entry->last_used = ++cache->clock;
+            cache->hits++;
+            return &entry->tree;
+        }
+    }
+    cache->misses++;
+    return NULL;
+}
+
+merkle_tree *tree_cache_store(tree_cache *cache, const uint8_t *owner, uint32_t tree_id, merkle_tree *tree) {
+    tree_cache_entry *victim = &cache->entries[0];
+
+    // Prefer an empty slot, otherwise the oldest one
+    for (size_t i = 0; i < cache->capacity; i++) {
+        tree_cache_entry *entry = &cache->entries[i];
+        if (!entry->valid) {
+            victim = entry;
+            break;
+        }
+        if (entry->last_used < victim->last_used) {
+            victim = entry;
+        }
+    }
+
+    if (victim->valid) {
+        merkle_tree_free(&victim->tree);
+        sphincs_wipe(victim, sizeof(*victim));
+    }
+    memcpy(victim->owner, owner, HASH_BYTES);
+    victim->tree_id = tree_id;
+    victim->last_used = ++cache->clock;
+    victim->tree = *tree;
+    victim->valid = 1;
+    tree->nodes = NULL;
+    return &victim->tree;
+}
@@ -0,0 +1,45 @@
+#ifndef TREE_CACHE_H
+#define TREE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "merkle.h"
+
+// Constants for error codes
+#define TREE_CACHE_SUCCESS 0
+#define TREE_CACHE_NULL_POINTER -1
+#define TREE_CACHE_OUT_OF_MEMORY -3
+
+// A built tree, identified by the secret seed it was derived from and an
+// id chosen by the owner (XMSS uses the bottom subtree index, or
+// XMSS_TOP_TREE for the tree over the subtree roots). The seed copy is
+// wiped when the entry is evicted or the cache freed.
+typedef struct {
+    uint8_t owner[HASH_BYTES];
+    uint32_t tree_id;
+    uint64_t last_used;
+    int valid;
+    merkle_tree tree;
+} tree_cache_entry;
+
+// Bounded least-recently-used set of built Merkle trees
+typedef struct {
+    tree_cache_entry *entries;
+    sphincs_arena *arena; // Backs the entries and cached trees, NULL for the heap
+    size_t capacity;
+    uint64_t clock;
+    uint64_t hits;
+    uint64_t misses;
+} tree_cache;
+
+int tree_cache_init(tree_cache *cache, size_t capacity, sphincs_arena *arena);
+void tree_cache_free(tree_cache *cache);
+
+// Returns the cached tree or NULL; a hit refreshes the entry's recency
+merkle_tree *tree_cache_lookup(tree_cache *cache, const uint8_t *owner, uint32_t tree_id);
+
+// Take ownership of a built tree, evicting the least recently used entry
+// when full. Returns the cached copy.
+merkle_tree *tree_cache_store(tree_cache *cache, const uint8_t *owner, uint32_t tree_id, merkle_tree *tree);
+
+#endif // TREE_CACHE_H
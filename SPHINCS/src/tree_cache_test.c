@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+#include "tree_cache.h"
+#include "test_util.h"
+
+/* A height 1 tree whose leaves are tagged with id, so lookups can be
+   told apart */
+static int make_tree(merkle_tree* tree, uint8_t id) {
+    if (merkle_tree_alloc(tree, 1, NULL) != MERKLE_SUCCESS) {
+        return 0;
+    }
+    memset(tree->nodes, id, MERKLE_NODES(1) * HASH_BYTES);
+    return 1;
+}
+
+static int holds(tree_cache* cache, const uint8_t* owner, uint32_t tree_id, uint8_t id) {
+    merkle_tree* tree = tree_cache_lookup(cache, owner, tree_id);
+    return tree && merkle_node(tree, 0, 0)[0] == id;
+}
+
+/* Lookups are keyed by owner and tree id, and count hits and misses */
+static void test_lookup(void) {
+    uint8_t owner_a[HASH_BYTES], owner_b[HASH_BYTES];
+    tree_cache cache;
+    merkle_tree tree;
+    int ok = 1;
+
+    memset(owner_a, 0xAA, HASH_BYTES);
+    memset(owner_b, 0xBB, HASH_BYTES);
+    if (tree_cache_init(&cache, 4, NULL) != TREE_CACHE_SUCCESS || !make_tree(&tree, 1)) {
+        report("Tree cache lookup", 0);
+        return;
+    }
+    ok &= tree_cache_lookup(&cache, owner_a, 0) == NULL;
+    ok &= tree_cache_store(&cache, owner_a, 0, &tree) != NULL;
+    ok &= tree.nodes == NULL; // Ownership moved into the cache
+    ok &= holds(&cache, owner_a, 0, 1);
+    ok &= tree_cache_lookup(&cache, owner_a, 1) == NULL;
+    ok &= tree_cache_lookup(&cache, owner_b, 0) == NULL;
+    ok &= cache.hits == 1 && cache.misses == 3;
+    tree_cache_free(&cache);
+    report("Tree cache lookup", ok);
+}
+
+/* A full cache evicts the least recently used entry and wipes its owner */
+static void test_eviction(void) {
+    uint8_t owner[HASH_BYTES];
+    tree_cache cache;
+    merkle_tree tree;
+    int ok = 1;
+
+    memset(owner, 0x11, HASH_BYTES);
+    if (tree_cache_init(&cache, 2, NULL) != TREE_CACHE_SUCCESS) {
+        report("Tree cache eviction", 0);
+        return;
+    }
+    for (uint8_t id = 1; id <= 2; ++id) {
+        ok &= make_tree(&tree, id) && tree_cache_store(&cache, owner, id, &tree) != NULL;
+    }
+    ok &= holds(&cache, owner, 1, 1); // Tree 2 is now the oldest
+
+    uint8_t other[HASH_BYTES];
+    memset(other, 0x22, HASH_BYTES);
+    ok &= make_tree(&tree, 3) && tree_cache_store(&cache, other, 3, &tree) != NULL;
+    ok &= tree_cache_lookup(&cache, owner, 2) == NULL;
+    ok &= holds(&cache, other, 3, 3);
+    ok &= holds(&cache, owner, 1, 1);
+
+    // Tree 1 was used last, so tree 3 goes next
+    ok &= make_tree(&tree, 4) && tree_cache_store(&cache, owner, 4, &tree) != NULL;
+    ok &= holds(&cache, owner, 4, 4);
+    ok &= tree_cache_lookup(&cache, other, 3) == NULL;
+    for (size_t i = 0; i < cache.capacity; ++i) {
+        ok &= memcmp(cache.entries[i].owner, other, HASH_BYTES) != 0;
+    }
+    tree_cache_free(&cache);
+    ok &= cache.entries == NULL;
+    report("Tree cache eviction", ok);
+}
+
+int main() {
+    test_lookup();
+    test_eviction();
+    return test_status();
+}
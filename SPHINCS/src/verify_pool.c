@@ -0,0 +1,552 @@
+#define _GNU_SOURCE
+#include "verify_pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct verify_request {
+    struct verify_request *next; // Completed list link
+    uint32_t key_id;
+    int status;
+    void *user;
+    size_t msglen;
+    sphincs_signature sig;
+    uint8_t msg[];
+} verify_request;
+
+// Prepared key plus one copy per NUMA node, so pinned workers never read
+// key state (seed midstate, Haraka constants) across the interconnect.
+// Only pinned workers make or use the copies: an unpinned thread may run
+// anywhere, so a copy it touched first would sit on an arbitrary node.
+typedef struct {
+    sphincs_prepared_pk primary;
+    _Atomic(sphincs_prepared_pk *) replica[VERIFY_POOL_MAX_NODES];
+} verify_key;
+
+// Each worker owns a deque: it takes the oldest request from the front,
+// while idle workers steal from the back. A deque is only locked for the
+// few instructions it takes to move pointers in or out.
+typedef struct {
+    pthread_mutex_t lock;
+    verify_request **ring;
+    size_t capacity;
+    size_t head;
+    size_t count;
+} verify_deque;
+
+typedef struct {
+    _Alignas(64) verify_deque deque;
+    sphincs_verify_pool *pool;
+    pthread_t thread;
+    int index;
+    int node;
+    int cpu;       // -1 when not pinned
+    int pinned;    // Affinity to cpu actually took effect
+    int *victims;  // Steal order: same node first, then the other nodes
+    int nvictims;
+} verify_worker;
+
+struct sphincs_verify_pool {
+    verify_worker *workers;
+    int nworkers;
+    int started;
+    int nodes;
+    atomic_uint next_worker;
+
+    // Requests sitting in deques; workers sleep on work when it hits zero
+    atomic_size_t queued;
+    atomic_int sleepers;
+    atomic_int stopping;
+    atomic_int submitters; // Calls inside sphincs_verify_submit; destroy waits for them
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+
+    verify_key *keys;
+    size_t max_keys;
+    atomic_size_t nkeys;
+    pthread_mutex_t keys_lock;
+
+    // Finished requests waiting to be polled, oldest first
+    pthread_mutex_t done_lock;
+    pthread_cond_t idle;
+    verify_request *done_head;
+    verify_request *done_tail;
+    atomic_size_t outstanding; // Submitted but not yet finished
+};
+
+static int deque_push(verify_deque *dq, verify_request *req) {
+    int ok = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count < dq->capacity) {
+        dq->ring[(dq->head + dq->count) % dq->capacity] = req;
+        dq->count++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return ok;
+}
+
+static verify_request *deque_pop_front(verify_deque *dq) {
+    verify_request *req = NULL;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        req = dq->ring[dq->head];
+        dq->head = (dq->head + 1) % dq->capacity;
+        dq->count--;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return req;
+}
+
+// Idle workers take the newest request from the back of a victim's deque,
+// leaving the oldest ones to the owner
+static verify_request *deque_steal(verify_deque *victim) {
+    verify_request *req = NULL;
+    pthread_mutex_lock(&victim->lock);
+    if (victim->count > 0) {
+        victim->count--;
+        req = victim->ring[(victim->head + victim->count) % victim->capacity];
+    }
+    pthread_mutex_unlock(&victim->lock);
+    return req;
+}
+
+static const sphincs_prepared_pk *key_for_worker(sphincs_verify_pool *pool, verify_key *key, const verify_worker *w) {
+    if (pool->nodes == 1 || !w->pinned) return &key->primary;
+
+    int node = w->node;
+    sphincs_prepared_pk *replica = atomic_load_explicit(&key->replica[node], memory_order_acquire);
+    if (replica) return replica;
+
+    // Allocated and written by a worker pinned to node, so under the
+    // default first-touch policy the copy lands in that node's memory
+    void *copy = NULL;
+    if (posix_memalign(&copy, 64, sizeof(sphincs_prepared_pk)) != 0) {
+        return &key->primary;
+    }
+    memcpy(copy, &key->primary, sizeof(sphincs_prepared_pk));
+    sphincs_prepared_pk *expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(&key->replica[node], &expected, copy,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        free(copy);
+        return expected;
+    }
+    return copy;
+}
+
+static void complete_request(sphincs_verify_pool *pool, verify_request *req) {
+    req->next = NULL;
+    pthread_mutex_lock(&pool->done_lock);
+    if (pool->done_tail) {
+        pool->done_tail->next = req;
+    } else {
+        pool->done_head = req;
+    }
+    pool->done_tail = req;
+    if (atomic_fetch_sub(&pool->outstanding, 1) == 1) {
+        pthread_cond_broadcast(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->done_lock);
+}
+
+static verify_request *find_work(verify_worker *w) {
+    sphincs_verify_pool *pool = w->pool;
+    verify_request *req = deque_pop_front(&w->deque);
+    for (int i = 0; !req && i < w->nvictims; i++) {
+        req = deque_steal(&pool->workers[w->victims[i]].deque);
+    }
+    if (req) {
+        atomic_fetch_sub(&pool->queued, 1);
+    }
+    return req;
+}
+
+static void *worker_main(void *arg) {
+    verify_worker *w = arg;
+    sphincs_verify_pool *pool = w->pool;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        w->pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0; // Best effort
+    }
+
+    for (;;) {
+        verify_request *req = find_work(w);
+        if (req) {
+            verify_key *key = &pool->keys[req->key_id];
+            req->status = sphincs_verify_prepared(&req->sig, req->msg, req->msglen, key_for_worker(pool, key, w));
+            complete_request(pool, req);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->sleepers, 1);
+        while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stopping)) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        atomic_fetch_sub(&pool->sleepers, 1);
+        int done = atomic_load(&pool->queued) == 0 && atomic_load(&pool->stopping);
+        pthread_mutex_unlock(&pool->lock);
+        if (done) break;
+    }
+    return NULL;
+}
+
+// Parse a sysfs cpulist such as "0-3,8-11" into set
+static void parse_cpulist(const char *list, cpu_set_t *set) {
+    while (*list) {
+        char *end;
+        long lo = strtol(list, &end, 10), hi;
+        if (end == list) break;
+        hi = lo;
+        if (*end == '-') {
+            list = end + 1;
+            hi = strtol(list, &end, 10);
+        }
+        for (long cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET((int)cpu, set);
+        }
+        list = *end == ',' ? end + 1 : end;
+        if (*end != ',') break;
+    }
+}
+
+// Fill cpu_node[] with the NUMA node of each CPU we may run on (-1 for the
+// rest) and return the number of nodes with at least one such CPU
+static int read_topology(int *cpu_node) {
+    cpu_set_t allowed;
+    int nodes = 0;
+
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_SET(0, &allowed);
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        cpu_node[cpu] = CPU_ISSET(cpu, &allowed) ? 0 : -1;
+    }
+
+    for (int node = 0; node < VERIFY_POOL_MAX_NODES; node++) {
+        char path[64], list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        if (!fgets(list, sizeof(list), f)) {
+            list[0] = '\0';
+        }
+        fclose(f);
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        parse_cpulist(list, &set);
+        int used = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set) && CPU_ISSET(cpu, &allowed)) {
+                cpu_node[cpu] = nodes;
+                used = 1;
+            }
+        }
+        nodes += used;
+    }
+    return nodes > 0 ? nodes : 1;
+}
+
+// Assign CPUs to workers round-robin over the nodes, so that a pool with
+// fewer workers than CPUs still spans every socket
+static void place_workers(sphincs_verify_pool *pool, const int *cpu_node, int pin) {
+    int next_cpu[VERIFY_POOL_MAX_NODES] = { 0 };
+
+    for (int i = 0; i < pool->nworkers; i++) {
+        verify_worker *w = &pool->workers[i];
+        w->node = i % pool->nodes;
+        w->cpu = -1;
+
+        for (int tries = 0; tries < pool->nodes && w->cpu < 0; tries++) {
+            int node = (i + tries) % pool->nodes;
+            for (int cpu = next_cpu[node]; cpu < CPU_SETSIZE; cpu++) {
+                if (cpu_node[cpu] == node) {
+                    w->node = node;
+                    w->cpu = cpu;
+                    next_cpu[node] = cpu + 1;
+                    break;
+                }
+            }
+        }
+        if (w->cpu < 0) {
+            // More workers than CPUs: start over from each node's first CPU
+            memset(next_cpu, 0, sizeof(next_cpu));
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (cpu_node[cpu] == w->node) {
+                    w->cpu = cpu;
+                    next_cpu[w->node] = cpu + 1;
+                    break;
+                }
+            }
+        }
+        if (!pin) {
+            w->cpu = -1;
+        }
+    }
+}
+
+static int build_victims(sphincs_verify_pool *pool) {
+    for (int i = 0; i < pool->nworkers; i++) {
+        verify_worker *w = &pool->workers[i];
+        w->victims = malloc((size_t)pool->nworkers * sizeof(*w->victims));
+        if (!w->victims) return VERIFY_POOL_OUT_OF_MEMORY;
+
+        w->nvictims = 0;
+        for (int remote = 0; remote < 2; remote++) {
+            for (int j = 1; j < pool->nworkers; j++) {
+                int v = (i + j) % pool->nworkers;
+                if ((pool->workers[v].node != w->node) == remote) {
+                    w->victims[w->nvictims++] = v;
+                }
+            }
+        }
+    }
+    return VERIFY_POOL_SUCCESS;
+}
+
+int sphincs_verify_pool_create(sphincs_verify_pool **out, const sphincs_verify_pool_config *config) {
+    if (!out || !config) return VERIFY_POOL_NULL_POINTER;
+
+    sphincs_verify_pool *pool = calloc(1, sizeof(*pool));
+    int *cpu_node = malloc(CPU_SETSIZE * sizeof(*cpu_node));
+    if (!pool || !cpu_node) {
+        free(pool);
+        free(cpu_node);
+        return VERIFY_POOL_OUT_OF_MEMORY;
+    }
+
+    pool->nodes = read_topology(cpu_node);
+    pool->nworkers = config->workers;
+    if (pool->nworkers <= 0) {
+        pool->nworkers = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            pool->nworkers += cpu_node[cpu] >= 0;
+        }
+    }
+    pool->max_keys = config->max_keys > 0 ? config->max_keys : 1;
+    size_t capacity = config->deque_capacity > 0 ? config->deque_capacity : 1;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_mutex_init(&pool->keys_lock, NULL);
+    pthread_mutex_init(&pool->done_lock, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    // Zero the workers before anything can fail, since destroy walks all
+    // of them to unwind
+    pool->workers = aligned_alloc(64, ((size_t)pool->nworkers * sizeof(*pool->workers) + 63) & ~(size_t)63);
+    if (pool->workers) {
+        memset(pool->workers, 0, (size_t)pool->nworkers * sizeof(*pool->workers));
+    }
+    pool->keys = calloc(pool->max_keys, sizeof(*pool->keys));
+    if (!pool->keys || !pool->workers) {
+        free(cpu_node);
+        sphincs_verify_pool_destroy(pool);
+        return VERIFY_POOL_OUT_OF_MEMORY;
+    }
+
+    int ret = VERIFY_POOL_SUCCESS;
+    for (int i = 0; i < pool->nworkers; i++) {
+        verify_worker *w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        pthread_mutex_init(&w->deque.lock, NULL);
+        w->deque.capacity = capacity;
+        w->deque.ring = malloc(capacity * sizeof(*w->deque.ring));
+        if (!w->deque.ring) {
+            ret = VERIFY_POOL_OUT_OF_MEMORY;
+        }
+    }
+    place_workers(pool, cpu_node, config->pin_workers);
+    free(cpu_node);
+    if (ret == VERIFY_POOL_SUCCESS) {
+        ret = build_victims(pool);
+    }
+
+    for (; ret == VERIFY_POOL_SUCCESS && pool->started < pool->nworkers; pool->started++) {
+        verify_worker *w = &pool->workers[pool->started];
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            ret = VERIFY_POOL_THREAD_ERROR;
+            break;
+        }
+    }
+    if (ret != VERIFY_POOL_SUCCESS) {
+        sphincs_verify_pool_destroy(pool);
+        return ret;
+    }
+
+    *out = pool;
+    return VERIFY_POOL_SUCCESS;
+}
+
+int sphincs_verify_pool_add_key(sphincs_verify_pool *pool, const sphincs_public_key *pk, uint32_t *key_id) {
+    if (!pool || !pk || !key_id) return VERIFY_POOL_NULL_POINTER;
+
+    pthread_mutex_lock(&pool->keys_lock);
+    size_t n = atomic_load(&pool->nkeys);
+    int ret = VERIFY_POOL_TOO_MANY_KEYS;
+    if (n < pool->max_keys) {
+        ret = sphincs_prepare_pk(&pool->keys[n].primary, pk);
+        if (ret == 0) {
+            *key_id = (uint32_t)n;
+            atomic_store_explicit(&pool->nkeys, n + 1, memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&pool->keys_lock);
+    return ret;
+}
+
+static int submit_request(sphincs_verify_pool *pool, uint32_t key_id, const sphincs_signature *sig,
+                          const uint8_t *msg, size_t msglen, void *user) {
+    if (atomic_load(&pool->stopping)) return VERIFY_POOL_SHUTTING_DOWN;
+
+    verify_request *req = malloc(sizeof(*req) + msglen);
+    if (!req) return VERIFY_POOL_OUT_OF_MEMORY;
+    req->key_id = key_id;
+    req->user = user;
+    req->msglen = msglen;
+    memcpy(&req->sig, sig, sizeof(*sig));
+    if (msglen > 0) {
+        memcpy(req->msg, msg, msglen);
+    }
+
+    // Spread submissions round-robin, spilling to the next deque when full.
+    // queued goes up first so a worker that takes req never underflows it.
+    atomic_fetch_add(&pool->outstanding, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    unsigned start = atomic_fetch_add_explicit(&pool->next_worker, 1, memory_order_relaxed);
+    int queued = 0;
+    for (int i = 0; i < pool->nworkers && !queued; i++) {
+        queued = deque_push(&pool->workers[(start + (unsigned)i) % (unsigned)pool->nworkers].deque, req);
+    }
+    if (!queued) {
+        atomic_fetch_sub(&pool->queued, 1);
+        pthread_mutex_lock(&pool->done_lock);
+        if (atomic_fetch_sub(&pool->outstanding, 1) == 1) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+        pthread_mutex_unlock(&pool->done_lock);
+        free(req);
+        return VERIFY_POOL_QUEUE_FULL;
+    }
+
+    // Workers publish themselves as sleepers before re-checking queued, so
+    // one of the two sides always sees the other
+    if (atomic_load(&pool->sleepers) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return VERIFY_POOL_SUCCESS;
+}
+
+int sphincs_verify_submit(sphincs_verify_pool *pool, uint32_t key_id, const sphincs_signature *sig,
+                          const uint8_t *msg, size_t msglen, void *user) {
+    if (!pool || !sig || (!msg && msglen > 0)) return VERIFY_POOL_NULL_POINTER;
+    if (key_id >= atomic_load_explicit(&pool->nkeys, memory_order_acquire)) return VERIFY_POOL_UNKNOWN_KEY;
+
+    // Announce ourselves before checking stopping: destroy sets stopping
+    // before waiting for submitters, so either we see it or it waits for us
+    atomic_fetch_add(&pool->submitters, 1);
+    int ret = submit_request(pool, key_id, sig, msg, msglen, user);
+    atomic_fetch_sub(&pool->submitters, 1);
+    return ret;
+}
+
+size_t sphincs_verify_poll(sphincs_verify_pool *pool, sphincs_verify_result *results, size_t max) {
+    if (!pool || !results) return 0;
+
+    pthread_mutex_lock(&pool->done_lock);
+    verify_request *list = pool->done_head;
+    verify_request *last = NULL;
+    size_t n = 0;
+    for (verify_request *req = list; req && n < max; req = req->next) {
+        last = req;
+        n++;
+    }
+    if (last) {
+        pool->done_head = last->next;
+        if (!pool->done_head) {
+            pool->done_tail = NULL;
+        }
+        last->next = NULL;
+    }
+    pthread_mutex_unlock(&pool->done_lock);
+
+    // Copy out and free outside the lock
+    size_t i = 0;
+    while (i < n) {
+        verify_request *next = list->next;
+        results[i].status = list->status;
+        results[i].user = list->user;
+        free(list);
+        list = next;
+        i++;
+    }
+    return n;
+}
+
+void sphincs_verify_pool_drain(sphincs_verify_pool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->done_lock);
+    while (atomic_load(&pool->outstanding) > 0) {
+        pthread_cond_wait(&pool->idle, &pool->done_lock);
+    }
+    pthread_mutex_unlock(&pool->done_lock);
+}
+
+void sphincs_verify_pool_destroy(sphincs_verify_pool *pool) {
+    if (!pool) return;
+
+    // Submits already past their stopping check finish queueing first, so
+    // the workers see every request before they are told to exit
+    atomic_store(&pool->stopping, 1);
+    while (atomic_load(&pool->submitters) > 0) {
+        sched_yield();
+    }
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    // Workers only exit once the deques are empty, so nothing is dropped
+    for (int i = 0; i < pool->started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    for (verify_request *req = pool->done_head; req;) {
+        verify_request *next = req->next;
+        free(req);
+        req = next;
+    }
+    if (pool->workers) {
+        for (int i = 0; i < pool->nworkers; i++) {
+            pthread_mutex_destroy(&pool->workers[i].deque.lock);
+            free(pool->workers[i].deque.ring);
+            free(pool->workers[i].victims);
+        }
+    }
+    if (pool->keys) {
+        for (size_t k = 0; k < pool->max_keys; k++) {
+            for (int node = 0; node < VERIFY_POOL_MAX_NODES; node++) {
+                free(atomic_load(&pool->keys[k].replica[node]));
+            }
+        }
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_mutex_destroy(&pool->done_lock);
+    pthread_mutex_destroy(&pool->keys_lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->keys);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,66 @@
+#ifndef VERIFY_POOL_H
+#define VERIFY_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sphincs.h"
+
+// Constants for error codes
+#define VERIFY_POOL_SUCCESS 0
+#define VERIFY_POOL_NULL_POINTER -1
+#define VERIFY_POOL_QUEUE_FULL -2
+#define VERIFY_POOL_SHUTTING_DOWN -3
+#define VERIFY_POOL_OUT_OF_MEMORY -4
+#define VERIFY_POOL_THREAD_ERROR -5
+#define VERIFY_POOL_UNKNOWN_KEY -6
+#define VERIFY_POOL_TOO_MANY_KEYS -7
+
+// NUMA nodes the pool tells apart; CPUs on higher nodes count as node 0
+#define VERIFY_POOL_MAX_NODES 8
+
+typedef struct {
+    int workers;           // Worker threads; 0 for one per CPU this process may run on
+    size_t deque_capacity; // Requests each worker's deque holds before submit spills to the next
+    size_t max_keys;       // Public keys that can be registered
+    int pin_workers;       // Pin each worker to one CPU, spreading them over the NUMA nodes; needed for key replicas
+} sphincs_verify_pool_config;
+
+// A finished request: status is the sphincs_verify_prepared result (1 for
+// a valid signature, 0 otherwise).
+typedef struct {
+    int status;
+    void *user;
+} sphincs_verify_result;
+
+typedef struct sphincs_verify_pool sphincs_verify_pool;
+
+int sphincs_verify_pool_create(sphincs_verify_pool **out, const sphincs_verify_pool_config *config);
+
+// Prepare pk and register it under *key_id. With pin_workers set, each
+// NUMA node gets its own copy of the prepared key, made by the first
+// pinned worker there to use it. Unpinned workers, or workers whose
+// pinning failed, all read the one shared copy: without pinning a
+// replica would land on whichever node its thread happened to run on.
+// Returns a sphincs_prepare_pk error if the key is unusable.
+int sphincs_verify_pool_add_key(sphincs_verify_pool *pool, const sphincs_public_key *pk, uint32_t *key_id);
+
+// Queue sig and msg (both copied) for verification under key_id. Never
+// blocks; returns VERIFY_POOL_QUEUE_FULL when every deque is at capacity.
+int sphincs_verify_submit(sphincs_verify_pool *pool, uint32_t key_id, const sphincs_signature *sig,
+                          const uint8_t *msg, size_t msglen, void *user);
+
+// Move up to max finished requests into results, oldest first, and return
+// how many were written. Never blocks.
+size_t sphincs_verify_poll(sphincs_verify_pool *pool, sphincs_verify_result *results, size_t max);
+
+// Block until every request submitted so far has finished and can be polled
+void sphincs_verify_pool_drain(sphincs_verify_pool *pool);
+
+// Stop accepting requests, finish the queued ones, join the workers and
+// free pool along with any results not yet polled. Submits racing with
+// destroy either queue their request, which is then finished, or return
+// VERIFY_POOL_SHUTTING_DOWN; calling anything on pool once destroy has
+// returned is the caller's bug.
+void sphincs_verify_pool_destroy(sphincs_verify_pool *pool);
+
+#endif // VERIFY_POOL_H
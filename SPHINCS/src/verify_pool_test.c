@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "verify_pool.h"
+#include "test_util.h"
+
+#define TEST_MESSAGES 8
+#define TEST_THREADS 4
+#define TEST_PER_THREAD 64
+
+static sphincs_signature sigs[TEST_MESSAGES];
+static uint8_t msgs[TEST_MESSAGES][16];
+
+static int sign_messages(sphincs_secret_key* sk) {
+    sphincs_signer signer;
+    uint8_t digest[HASH_BYTES];
+    int ok = sphincs_signer_init(&signer, sk, 0, NULL) == 0;
+
+    for (int i = 0; i < TEST_MESSAGES && ok; ++i) {
+        memset(msgs[i], 'a' + i, sizeof(msgs[i]));
+        ok &= sphincs_signer_sign_fors(&signer, &sigs[i], digest, msgs[i], sizeof(msgs[i])) == 0;
+        ok &= sphincs_signer_sign_layers(&signer, &sigs[i], digest) == 0;
+    }
+    sphincs_signer_free(&signer);
+    return ok;
+}
+
+/* Poll until count results have arrived, filling status by user index */
+static int collect(sphincs_verify_pool* pool, int* status, size_t count) {
+    sphincs_verify_result results[TEST_MESSAGES];
+    size_t got = 0;
+
+    sphincs_verify_pool_drain(pool);
+    for (size_t n; (n = sphincs_verify_poll(pool, results, TEST_MESSAGES)) > 0; got += n) {
+        for (size_t i = 0; i < n; ++i) {
+            status[(intptr_t)results[i].user] = results[i].status;
+        }
+    }
+    return got == count;
+}
+
+/* Valid signatures verify and a signature on another message does not */
+static void test_verify(const sphincs_public_key* pk) {
+    sphincs_verify_pool_config config = { .workers = 2, .deque_capacity = TEST_MESSAGES, .max_keys = 1 };
+    sphincs_verify_pool* pool;
+    uint32_t key_id;
+    int status[TEST_MESSAGES + 1];
+    int ok = 1;
+
+    if (sphincs_verify_pool_create(&pool, &config) != VERIFY_POOL_SUCCESS) {
+        report("Verify pool results", 0);
+        return;
+    }
+    ok &= sphincs_verify_pool_add_key(pool, pk, &key_id) == VERIFY_POOL_SUCCESS;
+    for (intptr_t i = 0; i < TEST_MESSAGES; ++i) {
+        ok &= sphincs_verify_submit(pool, key_id, &sigs[i], msgs[i], sizeof(msgs[i]), (void*)i) == VERIFY_POOL_SUCCESS;
+    }
+    ok &= sphincs_verify_submit(pool, key_id, &sigs[0], msgs[1], sizeof(msgs[1]), (void*)(intptr_t)TEST_MESSAGES) == VERIFY_POOL_SUCCESS;
+    ok &= collect(pool, status, TEST_MESSAGES + 1);
+    for (int i = 0; i < TEST_MESSAGES; ++i) {
+        ok &= status[i] == 1;
+    }
+    ok &= status[TEST_MESSAGES] == 0;
+    sphincs_verify_pool_destroy(pool);
+    report("Verify pool results", ok);
+}
+
+static void test_arguments(const sphincs_public_key* pk) {
+    sphincs_verify_pool_config config = { .workers = 1, .deque_capacity = 1, .max_keys = 1 };
+    sphincs_verify_pool* pool;
+    uint32_t key_id;
+    int ok = 1;
+
+    ok &= sphincs_verify_pool_create(NULL, &config) == VERIFY_POOL_NULL_POINTER;
+    if (sphincs_verify_pool_create(&pool, &config) != VERIFY_POOL_SUCCESS) {
+        report("Verify pool arguments", 0);
+        return;
+    }
+    ok &= sphincs_verify_submit(pool, 0, &sigs[0], msgs[0], sizeof(msgs[0]), NULL) == VERIFY_POOL_UNKNOWN_KEY;
+    ok &= sphincs_verify_pool_add_key(pool, pk, &key_id) == VERIFY_POOL_SUCCESS;
+    ok &= sphincs_verify_pool_add_key(pool, pk, &key_id) == VERIFY_POOL_TOO_MANY_KEYS;
+    ok &= sphincs_verify_submit(pool, key_id, NULL, msgs[0], 1, NULL) == VERIFY_POOL_NULL_POINTER;
+    ok &= sphincs_verify_submit(pool, key_id, &sigs[0], NULL, 1, NULL) == VERIFY_POOL_NULL_POINTER;
+    sphincs_verify_pool_destroy(pool);
+    report("Verify pool arguments", ok);
+}
+
+/* A failed allocation after the workers array exists must unwind cleanly.
+   Sanitizer builds need allocator_may_return_null=1 for this one */
+static void test_create_failure(void) {
+    sphincs_verify_pool_config config = { .workers = 4, .deque_capacity = 1, .max_keys = SIZE_MAX / 2 };
+    sphincs_verify_pool* pool = NULL;
+
+    int ok = sphincs_verify_pool_create(&pool, &config) == VERIFY_POOL_OUT_OF_MEMORY;
+    report("Verify pool create failure", ok && pool == NULL);
+}
+
+typedef struct {
+    sphincs_verify_pool* pool;
+    uint32_t key_id;
+    int accepted;
+} submitter;
+
+static void* submit_many(void* arg) {
+    submitter* s = arg;
+    for (int i = 0; i < TEST_PER_THREAD; ++i) {
+        int m = i % TEST_MESSAGES;
+        s->accepted += sphincs_verify_submit(s->pool, s->key_id, &sigs[m], msgs[m], sizeof(msgs[m]), NULL) == VERIFY_POOL_SUCCESS;
+    }
+    return NULL;
+}
+
+/* Submits from several threads; every accepted request comes back, and
+   destroy frees the ones nobody polled */
+static void test_concurrent_submit(const sphincs_public_key* pk) {
+    sphincs_verify_pool_config config = { .workers = 3, .deque_capacity = 16, .max_keys = 1 };
+    sphincs_verify_pool* pool;
+    submitter subs[TEST_THREADS];
+    pthread_t threads[TEST_THREADS];
+    sphincs_verify_result results[TEST_MESSAGES];
+    uint32_t key_id;
+    int ok = 1, accepted = 0, valid = 0, polled = 0;
+
+    if (sphincs_verify_pool_create(&pool, &config) != VERIFY_POOL_SUCCESS) {
+        report("Verify pool concurrent submit", 0);
+        return;
+    }
+    ok &= sphincs_verify_pool_add_key(pool, pk, &key_id) == VERIFY_POOL_SUCCESS;
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        subs[t] = (submitter){ pool, key_id, 0 };
+        pthread_create(&threads[t], NULL, submit_many, &subs[t]);
+    }
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        accepted += subs[t].accepted;
+    }
+    sphincs_verify_pool_drain(pool);
+    // Leave one batch behind for destroy
+    for (size_t n; polled + TEST_MESSAGES < accepted && (n = sphincs_verify_poll(pool, results, TEST_MESSAGES)) > 0; polled += (int)n) {
+        for (size_t i = 0; i < n; ++i) {
+            valid += results[i].status == 1;
+        }
+    }
+    ok &= accepted > 0 && valid == polled && polled + TEST_MESSAGES >= accepted;
+    sphincs_verify_pool_destroy(pool);
+    report("Verify pool concurrent submit", ok);
+}
+
+int main() {
+    static sphincs_public_key pk;
+    static sphincs_secret_key sk;
+    uint8_t seed[HASH_BYTES] = { 0x3C };
+
+    if (sphincs_keygen(&pk, &sk, seed) != 0 || !sign_messages(&sk)) {
+        report("Verify pool keygen", 0);
+        return 1;
+    }
+    test_arguments(&pk);
+    test_verify(&pk);
+    test_create_failure();
+    test_concurrent_submit(&pk);
+    return test_status();
+}
@@ -1,7 +1,6 @@
 
 #include "wots.h"
 #include <string.h>
-#include "rng.h"
 
 // Constants for error codes
 // Constants for error codes
@@ -30,46 +29,54 @@ static int constant_time_compare(const uint8_t* a, const uint8_t* b, size_t size
     return result == 0;
 }
 
-void wots_generate_private_key(uint8_t* private_key) {
-    rng_generate(private_key, WOTS_LEN * SHA256_DIGEST_SIZE);
+void wots_generate_private_key(const sphincs_hash_ctx* ctx, const uint8_t* seed, uint8_t* private_key) {
+    uint8_t input[SHA256_DIGEST_SIZE + 4];
+    memcpy(input, seed, SHA256_DIGEST_SIZE);
+    for (int i = 0; i < WOTS_LEN; ++i) {
+        input[SHA256_DIGEST_SIZE + 0] = (i >> 24) & 0xFF;
+        input[SHA256_DIGEST_SIZE + 1] = (i >> 16) & 0xFF;
+        input[SHA256_DIGEST_SIZE + 2] = (i >> 8) & 0xFF;
+        input[SHA256_DIGEST_SIZE + 3] = i & 0xFF;
+        hash_prf(ctx, private_key + i * SHA256_DIGEST_SIZE, input, sizeof(input));
+    }
 }
 
-static void chain(const uint8_t* start, int steps, uint8_t* result) {
+static void chain(const sphincs_hash_ctx* ctx, const uint8_t* start, int steps, uint8_t* result) {
     memcpy(result, start, SHA256_DIGEST_SIZE);
     for (int i = 0; i < steps; ++i) {
-        sha256(result, SHA256_DIGEST_SIZE, result);
+        hash_thash(ctx, result, result, SHA256_DIGEST_SIZE);
     }
 }
 
-void wots_generate_public_key(const uint8_t* private_key, uint8_t* public_key) {
+void wots_generate_public_key(const sphincs_hash_ctx* ctx, const uint8_t* private_key, uint8_t* public_key) {
     uint8_t tmp[WOTS_LEN * SHA256_DIGEST_SIZE];
     for (int i = 0; i < WOTS_LEN; ++i) {
-        chain(private_key + i * SHA256_DIGEST_SIZE, WOTS_W - 1, tmp + i * SHA256_DIGEST_SIZE);
+        chain(ctx, private_key + i * SHA256_DIGEST_SIZE, WOTS_W - 1, tmp + i * SHA256_DIGEST_SIZE);
     }
-    sha256(tmp, WOTS_LEN * SHA256_DIGEST_SIZE, public_key);
+    hash_thash(ctx, public_key, tmp, WOTS_LEN * SHA256_DIGEST_SIZE);
 }
 
-void wots_sign(const uint8_t* message, const uint8_t* private_key, uint8_t* signature) {
+void wots_sign(const sphincs_hash_ctx* ctx, const uint8_t* message, const uint8_t* private_key, uint8_t* signature) {
     uint8_t hash[SHA256_DIGEST_SIZE];
     uint8_t base_w[WOTS_LEN];
-    sha256((const uint8_t*)message, strlen((const char*)message), hash);
+    hash_h_msg(ctx, hash, (const uint8_t*)message, strlen((const char*)message));
     convert_to_base_w(hash, base_w);
     for (int i = 0; i < WOTS_LEN; ++i) {
-        chain(private_key + i * SHA256_DIGEST_SIZE, base_w[i], signature + i * SHA256_DIGEST_SIZE);
+        chain(ctx, private_key + i * SHA256_DIGEST_SIZE, base_w[i], signature + i * SHA256_DIGEST_SIZE);
     }
 }
 
-int wots_verify(const uint8_t* message, const uint8_t* signature, const uint8_t* public_key) {
-    if (!message || !signature || !public_key) return WOTS_NULL_POINTER;
+int wots_verify(const sphincs_hash_ctx* ctx, const uint8_t* message, const uint8_t* signature, const uint8_t* public_key) {
+    if (!ctx || !message || !signature || !public_key) return WOTS_NULL_POINTER;
     uint8_t hash[SHA256_DIGEST_SIZE];
     uint8_t base_w[WOTS_LEN];
     uint8_t tmp[WOTS_LEN * SHA256_DIGEST_SIZE];
     uint8_t reconstructed_public_key[SHA256_DIGEST_SIZE];
-    sha256(message, strlen((const char*)message), hash);
+    hash_h_msg(ctx, hash, message, strlen((const char*)message));
     convert_to_base_w(hash, base_w);
     for (int i = 0; i < WOTS_LEN; ++i) {
-        chain(signature + i * SHA256_DIGEST_SIZE, WOTS_W - 1 - base_w[i], tmp + i * SHA256_DIGEST_SIZE);
+        chain(ctx, signature + i * SHA256_DIGEST_SIZE, WOTS_W - 1 - base_w[i], tmp + i * SHA256_DIGEST_SIZE);
     }
-    sha256(tmp, WOTS_LEN * SHA256_DIGEST_SIZE, reconstructed_public_key);
+    hash_thash(ctx, reconstructed_public_key, tmp, WOTS_LEN * SHA256_DIGEST_SIZE);
     return constant_time_compare(reconstructed_public_key, public_key, SHA256_DIGEST_SIZE) ? WOTS_SUCCESS : WOTS_INVALID_SIGNATURE;
 }
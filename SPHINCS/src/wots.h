@@ -3,7 +3,7 @@
 #define WOTS_H
 
 #include <stdint.h>
-#include "sha256.h"
+#include "hash.h"
 #include <string.h>
 
 #define WOTS_W 16
@@ -11,9 +11,10 @@
 #define WOTS_LEN 67
 
 // Function prototypes
-void wots_generate_private_key(uint8_t* private_key);
-void wots_generate_public_key(const uint8_t* private_key, uint8_t* public_key);
-void wots_sign(const uint8_t* message, const uint8_t* private_key, uint8_t* signature);
-int wots_verify(const uint8_t* message, const uint8_t* signature, const uint8_t* public_key);
+// Expand seed into the WOTS_LEN chain secrets with ctx's PRF
+void wots_generate_private_key(const sphincs_hash_ctx* ctx, const uint8_t* seed, uint8_t* private_key);
+void wots_generate_public_key(const sphincs_hash_ctx* ctx, const uint8_t* private_key, uint8_t* public_key);
+void wots_sign(const sphincs_hash_ctx* ctx, const uint8_t* message, const uint8_t* private_key, uint8_t* signature);
+int wots_verify(const sphincs_hash_ctx* ctx, const uint8_t* message, const uint8_t* signature, const uint8_t* public_key);
 
 #endif
\ No newline at end of file
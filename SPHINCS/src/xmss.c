@@ -1,8 +1,10 @@
 
 #include "xmss.h"
-#include "sha256.h"
+#include "hash.h"
 #include "rng.h"
 #include "wots.h"  // Including WOTS+ for leaf computation
+#include "merkle.h"
+#include "tree_cache.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -55,109 +57,129 @@ void deserialize_xmss_multitree_public_key(xmss_multitree_public_key *pk, const
 
 
 
-static void compute_wots_leaf(uint8_t *leaf) {
+// Leaf leaf_idx of a layer is the WOTS+ public key whose private key is
+// expanded from PRF(layer seed || leaf_idx), so any tree of the layer can
+// be rebuilt on demand and always comes out the same.
+static void compute_wots_leaf(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, uint32_t leaf_idx, uint8_t *leaf) {
+    uint8_t input[HASH_BYTES + 4];
+    uint8_t leaf_seed[HASH_BYTES];
     uint8_t wots_sk[WOTS_LEN * HASH_BYTES];
-    wots_generate_private_key(wots_sk); // Generate WOTS+ private key
-    wots_generate_public_key(wots_sk, leaf); // Compute WOTS+ public key (the XMSS leaf)
-}
 
+    memcpy(input, sk_seed, HASH_BYTES);
+    input[HASH_BYTES + 0] = (leaf_idx >> 24) & 0xFF;
+    input[HASH_BYTES + 1] = (leaf_idx >> 16) & 0xFF;
+    input[HASH_BYTES + 2] = (leaf_idx >> 8) & 0xFF;
+    input[HASH_BYTES + 3] = leaf_idx & 0xFF;
+    hash_prf(ctx, leaf_seed, input, sizeof(input));
 
-static void xmss_thash(uint8_t* left, uint8_t* right, uint8_t* parent) {
-    uint8_t buffer[2 * HASH_BYTES];
-    memcpy(buffer, left, HASH_BYTES);
-    memcpy(buffer + HASH_BYTES, right, HASH_BYTES);
-    sha256(buffer, 2 * HASH_BYTES, parent);
+    wots_generate_private_key(ctx, leaf_seed, wots_sk); // Generate WOTS+ private key
+    wots_generate_public_key(ctx, wots_sk, leaf); // Compute WOTS+ public key (the XMSS leaf)
 }
-static void compute_subtree_root(uint32_t subtree_idx, uint8_t *root) {
-    uint32_t start_idx = subtree_idx << XMSS_SUBTREE_HEIGHT;
-    uint32_t end_idx = start_idx + (1 << XMSS_SUBTREE_HEIGHT);
 
-    // Temporary storage for tree nodes
-    uint8_t nodes[1 << (XMSS_SUBTREE_HEIGHT + 1)][HASH_BYTES];
 
-    // Compute WOTS+ leaves for the subtree
-    for (uint32_t i = start_idx; i < end_idx; i++) {
-        compute_wots_leaf(nodes[i - start_idx]);
-    }
+// Fill the leaves of a bottom subtree with WOTS+ public keys and hash it up
+static int build_subtree(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, uint32_t subtree_idx, sphincs_arena *arena, merkle_tree *tree) {
+    int ret = merkle_tree_alloc(tree, XMSS_SUBTREE_HEIGHT, arena);
+    if (ret != MERKLE_SUCCESS) return ret;
 
-    // Compute the subtree using a binary tree approach
-    for (int h = 0; h < XMSS_SUBTREE_HEIGHT; h++) {
-        for (int i = 0; i < (1 << (XMSS_SUBTREE_HEIGHT - h)) / 2; i++) {
-            xmss_thash(nodes[2 * i + (1 << h)], nodes[2 * i + 1 + (1 << h)], nodes[i + (1 << (h + 1))]);
-        }
+    uint32_t start_idx = subtree_idx << XMSS_SUBTREE_HEIGHT;
+    for (uint32_t i = 0; i < (1u << XMSS_SUBTREE_HEIGHT); i++) {
+        compute_wots_leaf(ctx, sk_seed, start_idx + i, merkle_node(tree, 0, i));
     }
-
-    // Copy the subtree root to the output
-    memcpy(root, nodes[1 << XMSS_SUBTREE_HEIGHT], HASH_BYTES);
+    merkle_tree_build(ctx, tree);
+    return MERKLE_SUCCESS;
 }
 
+static int compute_subtree_root(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, uint32_t subtree_idx, uint8_t *root) {
+    merkle_tree tree;
+    int ret = build_subtree(ctx, sk_seed, subtree_idx, NULL, &tree);
+    if (ret != MERKLE_SUCCESS) return ret;
 
-void xmss_multitree_compute_tree(uint8_t *root) {
-    uint8_t subtree_roots[XMSS_NUM_SUBTREES][HASH_BYTES];
+    memcpy(root, merkle_root(&tree), HASH_BYTES);
+    merkle_tree_free(&tree);
+    return MERKLE_SUCCESS;
+}
 
-    // Compute the roots of all subtrees
-    for (uint32_t i = 0; i < XMSS_NUM_SUBTREES; i++) {
-        compute_subtree_root(i, subtree_roots[i]);
-    }
+// Build the top tree, whose leaves are the roots of all bottom subtrees
+static int build_top_tree(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, sphincs_arena *arena, merkle_tree *top) {
+    int ret = merkle_tree_alloc(top, XMSS_TOP_HEIGHT, arena);
+    if (ret != MERKLE_SUCCESS) return ret;
 
-    // Build the main tree from the subtree roots using a binary tree approach
-    uint8_t nodes[1 << (XMSS_HEIGHT - XMSS_SUBTREE_HEIGHT + 1)][HASH_BYTES];
-    memcpy(nodes, subtree_roots, sizeof(subtree_roots));
-    for (int h = 0; h < XMSS_HEIGHT - XMSS_SUBTREE_HEIGHT; h++) {
-        for (int i = 0; i < (1 << (XMSS_HEIGHT - XMSS_SUBTREE_HEIGHT - h)) / 2; i++) {
-            xmss_thash(nodes[2 * i + (1 << h)], nodes[2 * i + 1 + (1 << h)], nodes[i + (1 << (h + 1))]);
+    for (uint32_t i = 0; i < (1u << XMSS_TOP_HEIGHT); i++) {
+        ret = compute_subtree_root(ctx, sk_seed, i, merkle_node(top, 0, i));
+        if (ret != MERKLE_SUCCESS) {
+            merkle_tree_free(top);
+            return ret;
         }
     }
-
-    // Copy the main tree root to the output
-    memcpy(root, nodes[1 << (XMSS_HEIGHT - XMSS_SUBTREE_HEIGHT)], HASH_BYTES);
+    merkle_tree_build(ctx, top);
+    return MERKLE_SUCCESS;
 }
 
 
-static void xmss_compute_auth_path(uint32_t leaf_idx, uint8_t auth_path[XMSS_NUM_SUBTREES][XMSS_SUBTREE_HEIGHT][HASH_BYTES]) {
-    // Define the tree structure, possibly as an array of nodes
-    uint8_t tree[1 << (XMSS_HEIGHT + 1)][HASH_BYTES]; // Example representation
+int xmss_multitree_compute_tree(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, uint8_t *root) {
+    merkle_tree top;
+    int ret = build_top_tree(ctx, sk_seed, NULL, &top);
+    if (ret != MERKLE_SUCCESS) return ret;
 
-    // Iterate through the subtrees
-    for (int subtree = 0; subtree < XMSS_NUM_SUBTREES; subtree++) {
-        uint32_t idx_in_subtree = leaf_idx & ((1 << XMSS_SUBTREE_HEIGHT) - 1);
-
-        // Iterate through the levels of the subtree
-        for (int level = 0; level < XMSS_SUBTREE_HEIGHT; level++) {
-            uint32_t node_idx = idx_in_subtree >> level;
-            
+    // Copy the main tree root to the output
+    memcpy(root, merkle_root(&top), HASH_BYTES);
+    merkle_tree_free(&top);
+    return MERKLE_SUCCESS;
+}
 
-            // Compute the left and right children
-            uint8_t *left_child = tree[(node_idx & ~1) << level];
-            uint8_t *right_child = tree[(node_idx | 1) << level];
 
-            // Store the sibling in the auth_path
-            if (node_idx & 1) {
-                memcpy(auth_path[subtree][level], left_child, HASH_BYTES);
-            } else {
-                memcpy(auth_path[subtree][level], right_child, HASH_BYTES);
-            }
+// Look a tree up in the cache, building it on first use. Without a cache
+// the tree is built into scratch and must go back through release_tree.
+static int acquire_tree(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, tree_cache *cache, uint32_t tree_id,
+                        merkle_tree *scratch, merkle_tree **out) {
+    if (cache) {
+        *out = tree_cache_lookup(cache, sk_seed, tree_id);
+        if (*out) return MERKLE_SUCCESS;
+    }
 
-            // Compute the parent node using SHA-256
-            uint8_t parent[HASH_BYTES];
-            uint8_t children[2 * HASH_BYTES];
-            memcpy(children, left_child, HASH_BYTES);
-            memcpy(children + HASH_BYTES, right_child, HASH_BYTES);
-            sha256(children, 2 * HASH_BYTES, parent);
+    sphincs_arena *arena = cache ? cache->arena : NULL;
+    int ret = tree_id == XMSS_TOP_TREE ? build_top_tree(ctx, sk_seed, arena, scratch)
+                                       : build_subtree(ctx, sk_seed, tree_id, arena, scratch);
+    if (ret != MERKLE_SUCCESS) return ret;
 
-            // Store the parent in the tree
-            memcpy(&tree[node_idx >> 1][level + 1], parent, HASH_BYTES);
-        }
+    *out = cache ? tree_cache_store(cache, sk_seed, tree_id, scratch) : scratch;
+    return MERKLE_SUCCESS;
+}
 
-        // Move to the next subtree
-        leaf_idx >>= XMSS_SUBTREE_HEIGHT;
+static void release_tree(tree_cache *cache, merkle_tree *scratch) {
+    if (!cache) {
+        merkle_tree_free(scratch);
     }
 }
 
 
+// The signature's auth path runs from the leaf to the layer root: the
+// levels inside the leaf's bottom subtree first, then the top tree's.
+static int xmss_compute_auth_path(const sphincs_hash_ctx *ctx, const uint8_t *sk_seed, tree_cache *cache, uint32_t leaf_idx,
+                                  uint8_t *leaf, uint8_t auth_path[XMSS_HEIGHT][HASH_BYTES]) {
+    uint32_t idx_in_subtree = leaf_idx & ((1u << XMSS_SUBTREE_HEIGHT) - 1);
+    merkle_tree scratch;
+    merkle_tree *tree;
+    int ret;
+
+    ret = acquire_tree(ctx, sk_seed, cache, leaf_idx >> XMSS_SUBTREE_HEIGHT, &scratch, &tree);
+    if (ret != MERKLE_SUCCESS) return ret;
+    memcpy(leaf, merkle_node(tree, 0, idx_in_subtree), HASH_BYTES);
+    merkle_auth_path(tree, idx_in_subtree, auth_path[0]);
+    release_tree(cache, &scratch);
+
+    ret = acquire_tree(ctx, sk_seed, cache, XMSS_TOP_TREE, &scratch, &tree);
+    if (ret != MERKLE_SUCCESS) return ret;
+    merkle_auth_path(tree, leaf_idx >> XMSS_SUBTREE_HEIGHT, auth_path[XMSS_SUBTREE_HEIGHT]);
+    release_tree(cache, &scratch);
+    return MERKLE_SUCCESS;
+}
+
+
 // Function to generate XMSS public and secret keys
-int xmss_keygen(xmss_multitree_public_key *pk, xmss_multitree_secret_key *sk, const uint8_t *seed) {
-    if (!pk || !sk || !seed) return -1; // Error handling
+int xmss_keygen(const sphincs_hash_ctx *ctx, xmss_multitree_public_key *pk, xmss_multitree_secret_key *sk, const uint8_t *seed) {
+    if (!ctx || !pk || !sk || !seed) return -1; // Error handling
 
     // Generate XMSS secret key seed
     rng_generate(sk->sk, HASH_BYTES);
@@ -166,25 +188,24 @@ int xmss_keygen(xmss_multitree_public_key *pk, xmss_multitree_secret_key *sk, co
     sk->idx = 0;
 
     // Compute the XMSS multi-tree root
-    xmss_multitree_compute_tree(pk->root);
+    if (xmss_multitree_compute_tree(ctx, sk->sk, pk->root) != MERKLE_SUCCESS) return -3;
 
     return 0; // Success
 }
 
 // Function to sign a message using XMSS
-int xmss_sign(xmss_multitree_signature *sig, const uint8_t *msg, xmss_multitree_secret_key *sk, const uint8_t *seed) {
-    if (!sig || !msg || !sk || !seed) return -1; // Error handling
+int xmss_sign(const sphincs_hash_ctx *ctx, xmss_multitree_signature *sig, const uint8_t *msg, xmss_multitree_secret_key *sk, tree_cache *cache) {
+    if (!ctx || !sig || !msg || !sk) return -1; // Error handling
     
     uint32_t leaf_idx = sk->idx; // Secret key index (leaf index)
 
     // Check for index overflow
     if (leaf_idx >= (1u << XMSS_HEIGHT)) return -2; // All indices exhausted
 
-    // Compute the leaf corresponding to the secret key index
-    compute_wots_leaf(sig->leaf);
-
-    // Compute the authentication path for the given leaf index
-    xmss_compute_auth_path(leaf_idx, sig->auth_path);
+    // Compute the leaf corresponding to the secret key index and its
+    // authentication path, building the trees involved on first use
+    sig->leaf_idx = leaf_idx;
+    if (xmss_compute_auth_path(ctx, sk->sk, cache, leaf_idx, sig->leaf, sig->auth_path) != MERKLE_SUCCESS) return -3;
 
     // Increment the secret key index
     sk->idx++;
@@ -193,29 +214,13 @@ int xmss_sign(xmss_multitree_signature *sig, const uint8_t *msg, xmss_multitree_
 }
 
 
-// Function to compute the root of a subtree given a leaf index and authentication path
-static void xmss_treehash(const uint8_t* leaf, uint32_t leaf_idx, int h, const uint8_t auth_path[XMSS_SUBTREE_HEIGHT][HASH_BYTES], uint8_t* root) {
-    uint8_t buffer[2 * HASH_BYTES];
-    memcpy(buffer, leaf, HASH_BYTES);
-    
-    for (int i = 0; i < h; i++) {
-        if (leaf_idx & 1) {
-            memcpy(buffer + HASH_BYTES, auth_path[i], HASH_BYTES);
-        } else {
-            memcpy(buffer, auth_path[i], HASH_BYTES);
-        }
-        sha256(buffer, 2 * HASH_BYTES, buffer);
-        leaf_idx >>= 1;
-    }
-    memcpy(root, buffer, HASH_BYTES);
-}
-
-int xmss_verify(const xmss_multitree_signature *sig, uint8_t leaf_idx, const uint8_t *msg, const xmss_multitree_public_key *pk) {
-    if (!sig || !msg || !pk) return -1;
+int xmss_verify(const sphincs_hash_ctx *ctx, const xmss_multitree_signature *sig, const uint8_t *msg, const xmss_multitree_public_key *pk) {
+    if (!ctx || !sig || !msg || !pk) return -1;
+    if (sig->leaf_idx >= (1u << XMSS_HEIGHT)) return 0;
 
     // Recompute the root from the signature
     uint8_t computed_root[HASH_BYTES];
-    xmss_treehash(sig->leaf, leaf_idx, XMSS_HEIGHT, sig->auth_path[0], computed_root);
+    merkle_root_from_path(ctx, sig->leaf, sig->leaf_idx, sig->auth_path[0], XMSS_HEIGHT, computed_root);
 
     // Compare the recomputed root to the public key
     return memcmp(computed_root, pk->root, HASH_BYTES) == 0;
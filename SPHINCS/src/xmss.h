@@ -3,12 +3,16 @@
 #define XMSS_H
 
 #include <stdint.h>
+#include "hash.h"
+#include "tree_cache.h"
 
 
 #define XMSS_SUBTREE_HEIGHT 4  // Height of each subtree
 #define HASH_BYTES 32
 #define XMSS_HEIGHT 10
 #define XMSS_NUM_SUBTREES (XMSS_HEIGHT / XMSS_SUBTREE_HEIGHT) // Number of subtrees
+#define XMSS_TOP_HEIGHT (XMSS_HEIGHT - XMSS_SUBTREE_HEIGHT) // Height of the tree over the subtree roots
+#define XMSS_TOP_TREE 0xFFFFFFFFu // Tree cache id of the tree over the subtree roots
 
 
 // XMSS public key structure for multi-tree variant
@@ -24,13 +28,15 @@ typedef struct {
 
 // XMSS signature structure for multi-tree variant
 typedef struct {
+    uint32_t leaf_idx; // Leaf the signature was made with
     uint8_t leaf[HASH_BYTES];
-    uint8_t auth_path[XMSS_NUM_SUBTREES][XMSS_SUBTREE_HEIGHT][HASH_BYTES];
+    uint8_t auth_path[XMSS_HEIGHT][HASH_BYTES]; // Bottom subtree levels, then the top tree's
 } xmss_multitree_signature;
 
-int xmss_keygen(xmss_multitree_public_key *pk, xmss_multitree_secret_key *sk, const uint8_t *seed);
-int xmss_sign(xmss_multitree_signature *sig, const uint8_t *msg, xmss_multitree_secret_key *sk, const uint8_t *seed);
-int xmss_verify(const xmss_multitree_signature *sig, const uint8_t *msg, const xmss_multitree_public_key *pk);
+int xmss_keygen(const sphincs_hash_ctx *ctx, xmss_multitree_public_key *pk, xmss_multitree_secret_key *sk, const uint8_t *seed);
+// cache may be NULL; otherwise trees are built on first use and kept there
+int xmss_sign(const sphincs_hash_ctx *ctx, xmss_multitree_signature *sig, const uint8_t *msg, xmss_multitree_secret_key *sk, tree_cache *cache);
+int xmss_verify(const sphincs_hash_ctx *ctx, const xmss_multitree_signature *sig, const uint8_t *msg, const xmss_multitree_public_key *pk);
 
 // Serialization and Deserialization Functions
 void serialize_xmss_multitree_public_key(const xmss_multitree_public_key *pk, uint8_t *output, uint32_t *offset);